@@ -0,0 +1,518 @@
+// Микробенчмарки горячих путей транспортного справочника.
+//
+// Сборка из корня репозитория:
+//   g++ -std=c++17 -O2 -pthread -Itransport-catalogue benchmarks/benchmarks.cpp
+//       $(ls transport-catalogue/*.cpp | grep -v main.cpp) -o benchmarks/run_benchmarks
+//
+// Запуск: run_benchmarks [--stops N] [--buses N] [--stops-per-bus N] [--iterations N] [--seed N]
+// Результаты выводятся в stdout одним JSON-документом, чтобы прогоны можно было сравнивать
+// между собой скриптом: для каждого бенчмарка — число итераций, суммарное, среднее,
+// минимальное и максимальное время итерации в наносекундах.
+
+#include "json.h"
+#include "map_renderer.h"
+#include "router.h"
+#include "svg.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    using namespace std::literals;
+
+    struct Config
+    {
+        size_t stops = 200;
+        size_t buses = 40;
+        size_t stops_per_bus = 12;
+        size_t iterations = 20;
+        uint32_t seed = 42;
+    };
+
+    struct Result
+    {
+        std::string name;
+        size_t iterations = 0;
+        int64_t total_ns = 0;
+        int64_t min_ns = std::numeric_limits<int64_t>::max();
+        int64_t max_ns = 0;
+    };
+
+    // Не даёт компилятору выбросить вычисления, результат которых не используется
+    volatile size_t sink = 0;
+
+    // Синтетический город: остановки, расстояния между соседями и маршруты
+    struct City
+    {
+        struct StopData
+        {
+            std::string name;
+            geo::Coordinates coordinates;
+        };
+
+        struct BusData
+        {
+            std::string name;
+            std::vector<size_t> stops;
+            bool is_roundtrip = false;
+        };
+
+        std::vector<StopData> stops;
+        std::vector<std::pair<size_t, size_t>> neighbours;
+        std::vector<int> distances;
+        std::vector<BusData> buses;
+    };
+
+    City GenerateCity(const Config &config)
+    {
+        std::mt19937 engine(config.seed);
+        std::uniform_real_distribution<double> lat(55.5, 55.9);
+        std::uniform_real_distribution<double> lng(37.3, 37.9);
+        std::uniform_int_distribution<int> distance(300, 3000);
+        std::uniform_int_distribution<size_t> stop_index(0, config.stops - 1);
+
+        City city;
+        for (size_t i = 0; i < config.stops; ++i)
+        {
+            city.stops.push_back({"Stop "s + std::to_string(i), {lat(engine), lng(engine)}});
+        }
+
+        for (size_t i = 0; i < config.buses; ++i)
+        {
+            City::BusData bus;
+            bus.name = std::to_string(i);
+            bus.is_roundtrip = i % 2 == 0;
+            for (size_t j = 0; j < config.stops_per_bus; ++j)
+            {
+                bus.stops.push_back(stop_index(engine));
+            }
+            if (bus.is_roundtrip)
+            {
+                bus.stops.push_back(bus.stops.front());
+            }
+            for (size_t j = 1; j < bus.stops.size(); ++j)
+            {
+                city.neighbours.emplace_back(bus.stops[j - 1], bus.stops[j]);
+                city.distances.push_back(distance(engine));
+            }
+            city.buses.push_back(std::move(bus));
+        }
+
+        return city;
+    }
+
+    void AddStops(const City &city, transport_catalogue::TransportCatalogue &catalogue)
+    {
+        for (const auto &stop : city.stops)
+        {
+            catalogue.AddStop(stop.name, stop.coordinates);
+        }
+    }
+
+    std::vector<const transport_catalogue::Stop *> ResolveStops(const City &city, const City::BusData &bus, const transport_catalogue::TransportCatalogue &catalogue)
+    {
+        std::vector<const transport_catalogue::Stop *> result;
+        result.reserve(bus.stops.size());
+        for (const size_t index : bus.stops)
+        {
+            result.push_back(catalogue.FindStop(city.stops[index].name));
+        }
+        return result;
+    }
+
+    void FillCatalogue(const City &city, transport_catalogue::TransportCatalogue &catalogue)
+    {
+        AddStops(city, catalogue);
+        for (size_t i = 0; i < city.neighbours.size(); ++i)
+        {
+            catalogue.AddDistance(catalogue.FindStop(city.stops[city.neighbours[i].first].name),
+                                  catalogue.FindStop(city.stops[city.neighbours[i].second].name),
+                                  city.distances[i]);
+        }
+        for (const auto &bus : city.buses)
+        {
+            catalogue.AddRoute(bus.name, ResolveStops(city, bus, catalogue), bus.is_roundtrip);
+        }
+    }
+
+    // Входной документ в схеме JsonReader (только base_requests) для замеров разбора и вывода JSON
+    json::Document BuildInputDocument(const City &city)
+    {
+        std::vector<json::Dict> road_distances(city.stops.size());
+        for (size_t i = 0; i < city.neighbours.size(); ++i)
+        {
+            road_distances[city.neighbours[i].first][city.stops[city.neighbours[i].second].name] = city.distances[i];
+        }
+
+        json::Array requests;
+        requests.reserve(city.stops.size() + city.buses.size());
+        for (size_t i = 0; i < city.stops.size(); ++i)
+        {
+            requests.emplace_back(json::Dict{
+                {"type", "Stop"s},
+                {"name", city.stops[i].name},
+                {"latitude", city.stops[i].coordinates.lat},
+                {"longitude", city.stops[i].coordinates.lng},
+                {"road_distances", std::move(road_distances[i])},
+            });
+        }
+
+        for (const auto &bus : city.buses)
+        {
+            json::Array stops;
+            for (const size_t index : bus.stops)
+            {
+                stops.emplace_back(city.stops[index].name);
+            }
+            requests.emplace_back(json::Dict{
+                {"type", "Bus"s},
+                {"name", bus.name},
+                {"stops", std::move(stops)},
+                {"is_roundtrip", bus.is_roundtrip},
+            });
+        }
+
+        return json::Document(json::Dict{{"base_requests", std::move(requests)}});
+    }
+
+    renderer::RenderSettings MakeRenderSettings()
+    {
+        renderer::RenderSettings settings;
+        settings.width = 1200.0;
+        settings.height = 1200.0;
+        settings.padding = 50.0;
+        settings.line_width = 14.0;
+        settings.stop_radius = 5.0;
+        settings.bus_label_font_size = 20;
+        settings.bus_label_offset = {7.0, 15.0};
+        settings.stop_label_font_size = 20;
+        settings.stop_label_offset = {7.0, -3.0};
+        settings.underlayer_color = svg::Rgba{255, 255, 255, 0.85};
+        settings.underlayer_width = 3.0;
+        settings.color_palette = {"green"s, svg::Rgb{255, 160, 0}, "red"s};
+        return settings;
+    }
+
+    class Runner
+    {
+    public:
+        explicit Runner(size_t iterations) : iterations_(iterations) {}
+
+        // Замеряет body; setup выполняется перед каждой итерацией и в замер не входит
+        void Run(std::string name, const std::function<void()> &setup, const std::function<void()> &body)
+        {
+            Result result;
+            result.name = std::move(name);
+            result.iterations = iterations_;
+
+            for (size_t i = 0; i < iterations_; ++i)
+            {
+                if (setup)
+                {
+                    setup();
+                }
+                const auto start = std::chrono::steady_clock::now();
+                body();
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                result.total_ns += elapsed;
+                result.min_ns = std::min<int64_t>(result.min_ns, elapsed);
+                result.max_ns = std::max<int64_t>(result.max_ns, elapsed);
+            }
+
+            results_.push_back(std::move(result));
+        }
+
+        void Run(std::string name, const std::function<void()> &body)
+        {
+            Run(std::move(name), nullptr, body);
+        }
+
+        // Время выводится целым числом наносекунд: числа json::Node с плавающей точкой
+        // печатаются с шестью значащими цифрами, а для сравнения прогонов нужна полная точность
+        void Print(const Config &config, std::ostream &output) const
+        {
+            output << "{\"config\":{\"stops\":" << config.stops
+                   << ",\"buses\":" << config.buses
+                   << ",\"stops_per_bus\":" << config.stops_per_bus
+                   << ",\"iterations\":" << config.iterations
+                   << ",\"seed\":" << config.seed << "},\"benchmarks\":[";
+
+            bool first = true;
+            for (const auto &result : results_)
+            {
+                if (!first)
+                {
+                    output << ',';
+                }
+                first = false;
+
+                // Имена бенчмарков не содержат символов, требующих экранирования
+                output << "{\"name\":\"" << result.name << '"'
+                       << ",\"iterations\":" << result.iterations
+                       << ",\"total_ns\":" << result.total_ns
+                       << ",\"mean_ns\":" << result.total_ns / static_cast<int64_t>(std::max<size_t>(1, result.iterations))
+                       << ",\"min_ns\":" << result.min_ns
+                       << ",\"max_ns\":" << result.max_ns << '}';
+            }
+            output << "]}" << std::endl;
+        }
+
+    private:
+        size_t iterations_;
+        std::vector<Result> results_;
+    };
+
+    Config ParseArguments(int argc, char *argv[])
+    {
+        Config config;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const std::string_view arg = argv[i];
+            const size_t value = std::stoul(argv[i + 1]);
+            if (arg == "--stops")
+                config.stops = std::max<size_t>(2, value);
+            else if (arg == "--buses")
+                config.buses = std::max<size_t>(1, value);
+            else if (arg == "--stops-per-bus")
+                config.stops_per_bus = std::max<size_t>(2, value);
+            else if (arg == "--iterations")
+                config.iterations = std::max<size_t>(1, value);
+            else if (arg == "--seed")
+                config.seed = static_cast<uint32_t>(value);
+            else
+                throw std::invalid_argument("unknown argument: "s + argv[i]);
+        }
+        return config;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const Config config = ParseArguments(argc, argv);
+    const City city = GenerateCity(config);
+    Runner runner(config.iterations);
+
+    // JSON
+    std::string input_text;
+    {
+        std::ostringstream out;
+        json::Print(BuildInputDocument(city), out);
+        input_text = out.str();
+    }
+
+    runner.Run("json::Load", [&]
+               {
+        std::istringstream in(input_text);
+        sink = sink + json::Load(in).GetRoot().AsMap().size(); });
+
+    runner.Run("json::LoadView", [&]
+               { sink = sink + json::LoadView(input_text).GetRoot().AsMap().size(); });
+
+    {
+        std::istringstream in(input_text);
+        const json::Document document = json::Load(in);
+        runner.Run("json::Print", [&]
+                   {
+            std::ostringstream out;
+            json::Print(document, out);
+            sink = sink + out.str().size(); });
+    }
+
+    // Справочник
+    transport_catalogue::TransportCatalogue catalogue;
+    FillCatalogue(city, catalogue);
+
+    {
+        std::unique_ptr<transport_catalogue::TransportCatalogue> fresh;
+        std::vector<std::vector<const transport_catalogue::Stop *>> bus_stops;
+        runner.Run(
+            "TransportCatalogue::AddRoute",
+            [&]
+            {
+                fresh = std::make_unique<transport_catalogue::TransportCatalogue>();
+                AddStops(city, *fresh);
+                bus_stops.clear();
+                for (const auto &bus : city.buses)
+                {
+                    bus_stops.push_back(ResolveStops(city, bus, *fresh));
+                }
+            },
+            [&]
+            {
+                for (size_t i = 0; i < city.buses.size(); ++i)
+                {
+                    fresh->AddRoute(city.buses[i].name, bus_stops[i], city.buses[i].is_roundtrip);
+                }
+            });
+    }
+
+    {
+        std::vector<std::pair<const transport_catalogue::Stop *, const transport_catalogue::Stop *>> pairs;
+        for (const auto &[from, to] : city.neighbours)
+        {
+            pairs.emplace_back(catalogue.FindStop(city.stops[from].name), catalogue.FindStop(city.stops[to].name));
+        }
+        runner.Run("TransportCatalogue::GetDistance", [&]
+                   {
+            for (const auto &[from, to] : pairs)
+            {
+                // Обратное направление проверяет запасной путь поиска
+                sink = sink + catalogue.GetDistance(from, to) + catalogue.GetDistance(to, from);
+            } });
+    }
+
+    runner.Run("TransportCatalogue::InformationRoute", [&]
+               {
+        for (const auto &bus : city.buses)
+        {
+            sink = sink + catalogue.InformationRoute(bus.name)->route_length;
+        } });
+
+    // Маршрутизация
+    const transport_catalogue::RouteSettings route_settings{6, 40.0};
+    runner.Run("Router::BuildGraph", [&]
+               {
+        // Только граф: предрасчёт маршрутов замеряется отдельно в graph::Router::Router
+        const transport_catalogue::Router router(route_settings, catalogue);
+        router.BuildGraph();
+        sink = sink + router.GetGraph().GetEdgeCount(); });
+
+    const transport_catalogue::Router router(route_settings, catalogue);
+    router.Build();
+    const auto &graph = router.GetGraph();
+
+    runner.Run("graph::Router::Router", [&]
+               {
+        const graph::Router<double> graph_router(graph);
+        sink = sink + graph_router.BuildRoute(0, 0).has_value(); });
+
+    {
+        const graph::Router<double> graph_router(graph);
+        std::mt19937 engine(config.seed);
+        // Чётные вершины — ожидание на остановке, с них начинаются и ими заканчиваются маршруты
+        std::uniform_int_distribution<size_t> stop(0, graph.GetVertexCount() / 2 - 1);
+        std::vector<std::pair<graph::VertexId, graph::VertexId>> queries;
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            queries.emplace_back(stop(engine) * 2, stop(engine) * 2);
+        }
+        runner.Run("graph::Router::BuildRoute", [&]
+                   {
+            for (const auto &[from, to] : queries)
+            {
+                const auto route = graph_router.BuildRoute(from, to);
+                sink = sink + (route ? route->edges.size() : 0);
+            } });
+    }
+
+    // Карта
+    const renderer::MapRenderer map_renderer(MakeRenderSettings());
+    const auto sorted_buses = catalogue.GetSortedBuses();
+    {
+        // Проекция всех остановок: поточечно и одним проходом по буферу координат
+        renderer::CoordinateBuffer coordinates;
+        coordinates.Reserve(city.stops.size());
+        for (const auto &stop : city.stops)
+        {
+            coordinates.Add(stop.coordinates);
+        }
+        const renderer::SphereProjector projector(coordinates, 1200.0, 1200.0, 50.0);
+        std::vector<svg::Point> points;
+        runner.Run("SphereProjector::operator()", [&]
+                   {
+            points.clear();
+            for (size_t i = 0; i < coordinates.Size(); ++i)
+            {
+                points.push_back(projector({coordinates.lat[i], coordinates.lng[i]}));
+            }
+            sink = sink + points.size(); });
+        runner.Run("SphereProjector::ProjectBatch", [&]
+                   {
+            projector.ProjectBatch(coordinates, points);
+            sink = sink + points.size(); });
+    }
+
+    runner.Run("MapRenderer::GetDocumentSVG", [&]
+               {
+        const svg::Document document = map_renderer.GetDocumentSVG(sorted_buses);
+        sink = sink + 1; });
+
+    {
+        const svg::Document document = map_renderer.GetDocumentSVG(sorted_buses);
+        runner.Run("svg::Document::Render", [&]
+                   {
+            std::ostringstream out;
+            document.Render(out);
+            sink = sink + out.str().size(); });
+    }
+
+    runner.Run("MapRenderer::RenderMap", [&]
+               {
+        io::OutputBuffer out;
+        map_renderer.RenderMap(sorted_buses, out);
+        sink = sink + out.Size(); });
+
+    // Часть карты из индекса: тайл первого уровня, то есть четверть карты
+    {
+        const renderer::MapIndex index(sorted_buses, map_renderer.GetSettings());
+        const renderer::Rect viewport = map_renderer.GetTileRect(1, 0, 0);
+
+        runner.Run("MapRenderer::GetViewportSVG", [&]
+                   {
+            const svg::Document document = map_renderer.GetViewportSVG(index, viewport);
+            sink = sink + 1; });
+
+        runner.Run("MapRenderer::RenderViewport", [&]
+                   {
+            io::OutputBuffer out;
+            map_renderer.RenderViewport(index, viewport, out);
+            sink = sink + out.Size(); });
+    }
+
+    // Кэш фрагментов: полное построение и обновление после изменения одного маршрута.
+    // Изменённый маршрут проходит те же остановки в обратном порядке, поэтому границы карты не меняются
+    if (!sorted_buses.empty())
+    {
+        transport_catalogue::Bus changed_bus = *sorted_buses.begin()->second;
+        std::reverse(changed_bus.stops_for_bus.begin(), changed_bus.stops_for_bus.end());
+        auto changed_buses = sorted_buses;
+        changed_buses.begin()->second = &changed_bus;
+
+        renderer::MapCache cache;
+        runner.Run("MapRenderer::UpdateCache (full)", [&]
+                   { cache = renderer::MapCache(); }, [&]
+                   {
+            map_renderer.UpdateCache(sorted_buses, cache);
+            sink = sink + cache.GetRebuiltCount(); });
+
+        bool changed = false;
+        runner.Run("MapRenderer::UpdateCache (one bus)", [&]
+                   {
+            changed = !changed;
+            map_renderer.UpdateCache(changed ? sorted_buses : changed_buses, cache); }, [&]
+                   {
+            map_renderer.UpdateCache(changed ? changed_buses : sorted_buses, cache);
+            sink = sink + cache.GetRebuiltCount(); });
+
+        runner.Run("MapCache::Render", [&]
+                   {
+            io::OutputBuffer out;
+            cache.Render(out);
+            sink = sink + out.Size(); });
+    }
+
+    runner.Print(config, std::cout);
+}
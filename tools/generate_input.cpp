@@ -0,0 +1,86 @@
+// Генератор синтетических входных документов для сквозных тестов на больших городах.
+//
+// Сборка из корня репозитория:
+//   g++ -std=c++17 -O2 -Itransport-catalogue tools/generate_input.cpp tools/input_generator.cpp
+//       transport-catalogue/geo.cpp -o tools/generate_input
+//
+// Запуск: generate_input [--seed N] [--stops N] [--buses N] [--route-length MIN:MAX]
+//                        [--roundtrip-ratio X] [--distance-density X] [--stat-requests N]
+//                        [--mix BUS:STOP:ROUTE:MAP] > input.json
+
+#include "input_generator.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    // Разбирает список чисел через двоеточие, например "40:40:19:1"
+    std::vector<double> ParseList(std::string_view text, size_t expected)
+    {
+        std::vector<double> result;
+        while (!text.empty())
+        {
+            const size_t colon = text.find(':');
+            result.push_back(std::stod(std::string(text.substr(0, colon))));
+            text.remove_prefix(colon == std::string_view::npos ? text.size() : colon + 1);
+        }
+        if (result.size() != expected)
+        {
+            throw std::invalid_argument("expected " + std::to_string(expected) + " values separated by ':'");
+        }
+        return result;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    tools::GeneratorSettings settings;
+    try
+    {
+        for (int i = 1; i < argc; i += 2)
+        {
+            const std::string_view arg = argv[i];
+            if (i + 1 == argc)
+            {
+                throw std::invalid_argument("missing value for argument: " + std::string(arg));
+            }
+            const std::string value = argv[i + 1];
+            if (arg == "--seed")
+                settings.seed = static_cast<uint32_t>(std::stoul(value));
+            else if (arg == "--stops")
+                settings.stop_count = std::stoul(value);
+            else if (arg == "--buses")
+                settings.bus_count = std::stoul(value);
+            else if (arg == "--route-length")
+            {
+                const auto lengths = ParseList(value, 2);
+                settings.min_route_length = static_cast<size_t>(lengths[0]);
+                settings.max_route_length = static_cast<size_t>(lengths[1]);
+            }
+            else if (arg == "--roundtrip-ratio")
+                settings.roundtrip_ratio = std::stod(value);
+            else if (arg == "--distance-density")
+                settings.distance_density = std::stod(value);
+            else if (arg == "--stat-requests")
+                settings.stat_request_count = std::stoul(value);
+            else if (arg == "--mix")
+            {
+                const auto mix = ParseList(value, 4);
+                settings.mix = {mix[0], mix[1], mix[2], mix[3]};
+            }
+            else
+                throw std::invalid_argument("unknown argument: " + std::string(arg));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    tools::GenerateInput(settings, std::cout);
+}
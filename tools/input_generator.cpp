@@ -0,0 +1,319 @@
+#include "input_generator.h"
+
+#include "geo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace tools
+{
+    namespace
+    {
+        // Прямоугольник, в котором равномерно расставляются остановки (примерно 45 x 30 км)
+        constexpr double MIN_LAT = 55.55;
+        constexpr double MAX_LAT = 55.95;
+        constexpr double MIN_LNG = 37.35;
+        constexpr double MAX_LNG = 37.85;
+        // Доля неизвестных имён в запросах Bus и Stop
+        constexpr double UNKNOWN_NAME_RATIO = 0.05;
+        // Доля пар соседних остановок маршрута, для которых задано и обратное расстояние
+        constexpr double REVERSE_DISTANCE_RATIO = 0.3;
+
+        // Сетка для выбора соседних остановок: в среднем несколько остановок на ячейку
+        class StopGrid
+        {
+        public:
+            explicit StopGrid(const std::vector<geo::Coordinates> &stops)
+                : side_(std::max<size_t>(1, static_cast<size_t>(std::sqrt(stops.size() / 4.0)))), cells_(side_ * side_)
+            {
+                for (size_t i = 0; i < stops.size(); ++i)
+                {
+                    cells_[GetCell(stops[i])].push_back(i);
+                }
+            }
+
+            // Случайная остановка из ячейки точки и восьми соседних, отличная от самой остановки, если это возможно
+            size_t PickNeighbour(size_t stop, const geo::Coordinates &coordinates, std::mt19937 &engine) const
+            {
+                const size_t cell = GetCell(coordinates);
+                const size_t row = cell / side_;
+                const size_t column = cell % side_;
+
+                candidates_.clear();
+                for (size_t r = row > 0 ? row - 1 : 0; r <= std::min(row + 1, side_ - 1); ++r)
+                {
+                    for (size_t c = column > 0 ? column - 1 : 0; c <= std::min(column + 1, side_ - 1); ++c)
+                    {
+                        for (const size_t candidate : cells_[r * side_ + c])
+                        {
+                            if (candidate != stop)
+                            {
+                                candidates_.push_back(candidate);
+                            }
+                        }
+                    }
+                }
+
+                if (candidates_.empty())
+                {
+                    return stop;
+                }
+                return candidates_[std::uniform_int_distribution<size_t>(0, candidates_.size() - 1)(engine)];
+            }
+
+        private:
+            size_t side_;
+            std::vector<std::vector<size_t>> cells_;
+            mutable std::vector<size_t> candidates_;
+
+            size_t GetCell(const geo::Coordinates &coordinates) const
+            {
+                const auto row = static_cast<size_t>((coordinates.lat - MIN_LAT) / (MAX_LAT - MIN_LAT) * side_);
+                const auto column = static_cast<size_t>((coordinates.lng - MIN_LNG) / (MAX_LNG - MIN_LNG) * side_);
+                return std::min(row, side_ - 1) * side_ + std::min(column, side_ - 1);
+            }
+        };
+
+        struct Bus
+        {
+            std::vector<size_t> stops;
+            bool is_roundtrip = false;
+        };
+
+        class Generator
+        {
+        public:
+            Generator(const GeneratorSettings &settings) : settings_(settings), engine_(settings.seed) {}
+
+            void Run(std::ostream &output)
+            {
+                GenerateStops();
+                GenerateBuses();
+                GenerateExtraDistances();
+
+                const auto flags = output.flags();
+                const auto precision = output.precision();
+                output << std::setprecision(9);
+
+                output << "{\n\"base_requests\": [\n";
+                PrintStops(output);
+                PrintBuses(output);
+                output << "],\n";
+                PrintSettings(output);
+                output << "\"stat_requests\": [\n";
+                PrintStatRequests(output);
+                output << "]\n}\n";
+
+                output.flags(flags);
+                output.precision(precision);
+            }
+
+        private:
+            const GeneratorSettings &settings_;
+            std::mt19937 engine_;
+            std::vector<geo::Coordinates> stops_;
+            std::vector<Bus> buses_;
+            std::vector<std::vector<std::pair<size_t, int>>> distances_;
+            std::unordered_set<uint64_t> distance_keys_;
+
+            double Uniform(double from, double to)
+            {
+                return std::uniform_real_distribution<double>(from, to)(engine_);
+            }
+
+            size_t UniformIndex(size_t count)
+            {
+                return std::uniform_int_distribution<size_t>(0, count - 1)(engine_);
+            }
+
+            void GenerateStops()
+            {
+                stops_.reserve(settings_.stop_count);
+                for (size_t i = 0; i < settings_.stop_count; ++i)
+                {
+                    stops_.push_back({Uniform(MIN_LAT, MAX_LAT), Uniform(MIN_LNG, MAX_LNG)});
+                }
+                distances_.resize(stops_.size());
+            }
+
+            // Дорожное расстояние длиннее расстояния по прямой; повторно расстояние для пары не задаётся
+            void AddDistance(size_t from, size_t to)
+            {
+                if (from == to || !distance_keys_.insert(static_cast<uint64_t>(from) << 32 | to).second)
+                {
+                    return;
+                }
+                const double straight = geo::ComputeDistance(stops_[from], stops_[to]);
+                distances_[from].emplace_back(to, std::max(1, static_cast<int>(std::ceil(straight * Uniform(1.1, 1.4)))));
+            }
+
+            void GenerateBuses()
+            {
+                if (stops_.size() < 2)
+                {
+                    return;
+                }
+
+                const StopGrid grid(stops_);
+                const size_t min_length = std::max<size_t>(2, settings_.min_route_length);
+                const size_t max_length = std::max(min_length, settings_.max_route_length);
+
+                buses_.resize(settings_.bus_count);
+                for (auto &bus : buses_)
+                {
+                    bus.is_roundtrip = Uniform(0.0, 1.0) < settings_.roundtrip_ratio;
+                    const size_t length = min_length + UniformIndex(max_length - min_length + 1);
+
+                    // Маршрут — случайное блуждание по соседним остановкам
+                    bus.stops.push_back(UniformIndex(stops_.size()));
+                    while (bus.stops.size() < length)
+                    {
+                        const size_t current = bus.stops.back();
+                        bus.stops.push_back(grid.PickNeighbour(current, stops_[current], engine_));
+                    }
+                    if (bus.is_roundtrip)
+                    {
+                        bus.stops.push_back(bus.stops.front());
+                    }
+
+                    for (size_t i = 1; i < bus.stops.size(); ++i)
+                    {
+                        AddDistance(bus.stops[i - 1], bus.stops[i]);
+                        if (Uniform(0.0, 1.0) < REVERSE_DISTANCE_RATIO)
+                        {
+                            AddDistance(bus.stops[i], bus.stops[i - 1]);
+                        }
+                    }
+                }
+            }
+
+            void GenerateExtraDistances()
+            {
+                if (stops_.size() < 2 || settings_.distance_density <= 0.0)
+                {
+                    return;
+                }
+
+                const StopGrid grid(stops_);
+                const double whole = std::floor(settings_.distance_density);
+                const double fraction = settings_.distance_density - whole;
+                for (size_t stop = 0; stop < stops_.size(); ++stop)
+                {
+                    const size_t count = static_cast<size_t>(whole) + (Uniform(0.0, 1.0) < fraction ? 1 : 0);
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        AddDistance(stop, grid.PickNeighbour(stop, stops_[stop], engine_));
+                    }
+                }
+            }
+
+            static std::string StopName(size_t index)
+            {
+                return "Stop " + std::to_string(index);
+            }
+
+            static std::string BusName(size_t index)
+            {
+                return "Bus " + std::to_string(index);
+            }
+
+            void PrintStops(std::ostream &output) const
+            {
+                for (size_t i = 0; i < stops_.size(); ++i)
+                {
+                    output << "{\"type\": \"Stop\", \"name\": \"" << StopName(i)
+                           << "\", \"latitude\": " << stops_[i].lat
+                           << ", \"longitude\": " << stops_[i].lng
+                           << ", \"road_distances\": {";
+                    bool first = true;
+                    for (const auto &[to, distance] : distances_[i])
+                    {
+                        output << (first ? "" : ", ") << '"' << StopName(to) << "\": " << distance;
+                        first = false;
+                    }
+                    output << "}}" << (i + 1 < stops_.size() || !buses_.empty() ? ",\n" : "\n");
+                }
+            }
+
+            void PrintBuses(std::ostream &output) const
+            {
+                for (size_t i = 0; i < buses_.size(); ++i)
+                {
+                    const Bus &bus = buses_[i];
+                    output << "{\"type\": \"Bus\", \"name\": \"" << BusName(i) << "\", \"stops\": [";
+                    for (size_t j = 0; j < bus.stops.size(); ++j)
+                    {
+                        output << (j > 0 ? ", " : "") << '"' << StopName(bus.stops[j]) << '"';
+                    }
+                    output << "], \"is_roundtrip\": " << (bus.is_roundtrip ? "true" : "false") << '}'
+                           << (i + 1 < buses_.size() ? ",\n" : "\n");
+                }
+            }
+
+            static void PrintSettings(std::ostream &output)
+            {
+                output << "\"render_settings\": {\"width\": 1200, \"height\": 1200, \"padding\": 50, "
+                          "\"stop_radius\": 5, \"line_width\": 14, "
+                          "\"bus_label_font_size\": 20, \"bus_label_offset\": [7, 15], "
+                          "\"stop_label_font_size\": 20, \"stop_label_offset\": [7, -3], "
+                          "\"underlayer_color\": [255, 255, 255, 0.85], \"underlayer_width\": 3, "
+                          "\"color_palette\": [\"green\", [255, 160, 0], \"red\"]},\n"
+                          "\"routing_settings\": {\"bus_wait_time\": 6, \"bus_velocity\": 40},\n";
+            }
+
+            void PrintStatRequests(std::ostream &output)
+            {
+                const auto &mix = settings_.mix;
+                std::discrete_distribution<int> type({stops_.empty() ? 0.0 : mix.bus,
+                                                      stops_.empty() ? 0.0 : mix.stop,
+                                                      stops_.empty() ? 0.0 : mix.route,
+                                                      mix.map});
+
+                for (size_t id = 1; id <= settings_.stat_request_count; ++id)
+                {
+                    output << "{\"id\": " << id << ", ";
+                    switch (type(engine_))
+                    {
+                    case 0:
+                        output << "\"type\": \"Bus\", \"name\": \"" << RequestName(buses_.size(), BusName) << "\"}";
+                        break;
+                    case 1:
+                        output << "\"type\": \"Stop\", \"name\": \"" << RequestName(stops_.size(), StopName) << "\"}";
+                        break;
+                    case 2:
+                        // Маршрут ищется только между существующими остановками
+                        output << "\"type\": \"Route\", \"from\": \"" << StopName(UniformIndex(stops_.size()))
+                               << "\", \"to\": \"" << StopName(UniformIndex(stops_.size())) << "\"}";
+                        break;
+                    default:
+                        output << "\"type\": \"Map\"}";
+                        break;
+                    }
+                    output << (id < settings_.stat_request_count ? ",\n" : "\n");
+                }
+            }
+
+            // Имя существующего объекта или, с небольшой вероятностью, неизвестное имя
+            template <typename NameFunction>
+            std::string RequestName(size_t count, NameFunction name)
+            {
+                if (count == 0 || Uniform(0.0, 1.0) < UNKNOWN_NAME_RATIO)
+                {
+                    return name(count + UniformIndex(1000));
+                }
+                return name(UniformIndex(count));
+            }
+        };
+    }
+
+    void GenerateInput(const GeneratorSettings &settings, std::ostream &output)
+    {
+        Generator(settings).Run(output);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+namespace tools
+{
+    // Доли типов запросов в stat_requests; доли задаются относительными весами
+    struct StatRequestMix
+    {
+        double bus = 40.0;
+        double stop = 40.0;
+        double route = 19.0;
+        double map = 1.0;
+    };
+
+    struct GeneratorSettings
+    {
+        uint32_t seed = 1;
+        size_t stop_count = 1000;
+        size_t bus_count = 100;
+        // Число остановок маршрута (без повтора конечной у кольцевых) выбирается равномерно из отрезка
+        size_t min_route_length = 5;
+        size_t max_route_length = 30;
+        // Доля кольцевых маршрутов
+        double roundtrip_ratio = 0.5;
+        // Среднее число дополнительных записей road_distances на остановку — до соседних остановок,
+        // через которые не проходит ни один маршрут (как в полной дорожной сети реальных фидов)
+        double distance_density = 1.0;
+        size_t stat_request_count = 1000;
+        StatRequestMix mix;
+    };
+
+    // Записывает детерминированный (для одинакового seed) входной документ в схеме JsonReader:
+    // base_requests, render_settings, routing_settings и stat_requests
+    void GenerateInput(const GeneratorSettings &settings, std::ostream &output);
+}
@@ -0,0 +1,254 @@
+// Замер масштабирования на синтетических городах от тысячи до миллиона остановок.
+//
+// Сборка из корня репозитория:
+//   g++ -std=c++17 -O2 -pthread -Itransport-catalogue -Itools tools/scaling_harness.cpp tools/input_generator.cpp
+//       $(ls transport-catalogue/*.cpp | grep -v main.cpp) -o tools/scaling_harness
+//
+// Запуск: scaling_harness [--sizes 1000,10000,100000,1000000] [--seed N] [--stat-requests N]
+//                         [--max-route-stops N] [--max-map-stops N] [--threads N]
+//                         [--mix BUS:STOP:ROUTE:MAP]
+//
+// Для каждого размера генерируется документ (автобусов — десятая часть от числа остановок),
+// затем замеряются этапы: разбор JSON, заполнение справочника, построение графа, предрасчёт
+// маршрутов и ответы на запросы по типам. Результат по каждому размеру выводится в stdout
+// отдельной строкой JSON. Предрасчёт маршрутов требует O(V^2) памяти и O(V^3) времени,
+// поэтому для городов больше --max-route-stops маршрутизация и запросы Route пропускаются;
+// так же карта не рисуется для городов больше --max-map-stops.
+// С --threads N все запросы дополнительно выполняются одним вызовом PrintFunction в пуле из N потоков
+// на новом JsonReader, где карта ещё не отрисована: запросы Map отрисовывают её лениво, из задач пула.
+
+#include "input_generator.h"
+#include "json.h"
+#include "json_reader.h"
+#include "output_buffer.h"
+#include "thread_pool.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    struct HarnessSettings
+    {
+        std::vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+        uint32_t seed = 1;
+        size_t stat_request_count = 1000;
+        size_t max_route_stops = 2000;
+        size_t max_map_stops = 100000;
+        size_t thread_count = 0;
+        tools::StatRequestMix mix;
+    };
+
+    struct QueryStats
+    {
+        size_t count = 0;
+        int64_t total_ns = 0;
+        int64_t max_ns = 0;
+    };
+
+    class Stopwatch
+    {
+    public:
+        int64_t ElapsedNs() const
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+    };
+
+    void RunSize(const HarnessSettings &harness, size_t stop_count, std::ostream &output)
+    {
+        tools::GeneratorSettings settings;
+        settings.seed = harness.seed;
+        settings.stop_count = stop_count;
+        settings.bus_count = std::max<size_t>(1, stop_count / 10);
+        settings.stat_request_count = harness.stat_request_count;
+        settings.mix = harness.mix;
+        const bool with_routing = stop_count <= harness.max_route_stops;
+        if (!with_routing)
+        {
+            settings.mix.route = 0.0;
+        }
+        if (stop_count > harness.max_map_stops)
+        {
+            settings.mix.map = 0.0;
+        }
+
+        std::string input;
+        {
+            std::ostringstream generated;
+            tools::GenerateInput(settings, generated);
+            input = generated.str();
+        }
+        const size_t input_bytes = input.size();
+        const std::string parallel_input = harness.thread_count > 0 ? input : std::string();
+
+        Stopwatch load_timer;
+        JsonReader reader(json::LoadView(std::move(input)));
+        const int64_t load_ns = load_timer.ElapsedNs();
+
+        transport_catalogue::TransportCatalogue catalogue;
+        Stopwatch catalogue_timer;
+        reader.AddCatalogue(catalogue);
+        const int64_t catalogue_ns = catalogue_timer.ElapsedNs();
+
+        const transport_catalogue::Router router(reader.FillRoutingSettings(reader.GetRoutingSettings()), catalogue);
+        int64_t graph_build_ns = 0;
+        int64_t preprocessing_ns = 0;
+        if (with_routing)
+        {
+            // Этапы замеряются по отдельности: BuildGraph() строит только граф,
+            // после него Build() выполняет только предрасчёт
+            Stopwatch graph_timer;
+            router.BuildGraph();
+            graph_build_ns = graph_timer.ElapsedNs();
+
+            Stopwatch preprocessing_timer;
+            router.Build();
+            preprocessing_ns = preprocessing_timer.ElapsedNs();
+        }
+
+        std::map<std::string, QueryStats> queries;
+        io::OutputBuffer response;
+        for (const auto &request : reader.GetStatRequests().AsArray())
+        {
+            const auto &request_map = request.AsMap();
+            response.Clear();
+
+            Stopwatch query_timer;
+            reader.PrintResponse(request_map, catalogue, router, response);
+            const int64_t elapsed = query_timer.ElapsedNs();
+
+            QueryStats &stats = queries[std::string(request_map.at("type").AsStringView())];
+            ++stats.count;
+            stats.total_ns += elapsed;
+            stats.max_ns = std::max(stats.max_ns, elapsed);
+        }
+
+        int64_t parallel_ns = 0;
+        if (harness.thread_count > 0)
+        {
+            JsonReader parallel_reader(json::LoadView(parallel_input));
+            parallel::ThreadPool pool(harness.thread_count);
+            parallel_reader.SetThreadPool(&pool);
+            io::OutputBuffer discard([](std::string_view) {});
+
+            Stopwatch parallel_timer;
+            parallel_reader.PrintFunction(catalogue, router, discard);
+            parallel_ns = parallel_timer.ElapsedNs();
+        }
+
+        output << "{\"stops\":" << stop_count
+               << ",\"buses\":" << settings.bus_count
+               << ",\"input_bytes\":" << input_bytes
+               << ",\"load_ns\":" << load_ns
+               << ",\"catalogue_ns\":" << catalogue_ns
+               << ",\"routing\":" << (with_routing ? "true" : "false");
+        if (with_routing)
+        {
+            output << ",\"graph_vertices\":" << router.GetGraph().GetVertexCount()
+                   << ",\"graph_edges\":" << router.GetGraph().GetEdgeCount()
+                   << ",\"graph_build_ns\":" << graph_build_ns
+                   << ",\"preprocessing_ns\":" << preprocessing_ns;
+        }
+        if (harness.thread_count > 0)
+        {
+            output << ",\"threads\":" << harness.thread_count
+                   << ",\"parallel_answers_ns\":" << parallel_ns;
+        }
+        output << ",\"queries\":{";
+        bool first = true;
+        for (const auto &[type, stats] : queries)
+        {
+            output << (first ? "" : ",") << '"' << type << "\":{\"count\":" << stats.count
+                   << ",\"total_ns\":" << stats.total_ns
+                   << ",\"mean_ns\":" << stats.total_ns / static_cast<int64_t>(stats.count)
+                   << ",\"max_ns\":" << stats.max_ns << '}';
+            first = false;
+        }
+        output << "}}" << std::endl;
+    }
+
+    std::vector<size_t> ParseSizes(std::string_view text)
+    {
+        std::vector<size_t> result;
+        while (!text.empty())
+        {
+            const size_t comma = text.find(',');
+            result.push_back(std::stoul(std::string(text.substr(0, comma))));
+            text.remove_prefix(comma == std::string_view::npos ? text.size() : comma + 1);
+        }
+        return result;
+    }
+
+    tools::StatRequestMix ParseMix(std::string_view text)
+    {
+        std::vector<double> weights;
+        while (!text.empty())
+        {
+            const size_t colon = text.find(':');
+            weights.push_back(std::stod(std::string(text.substr(0, colon))));
+            text.remove_prefix(colon == std::string_view::npos ? text.size() : colon + 1);
+        }
+        if (weights.size() != 4)
+        {
+            throw std::invalid_argument("expected 4 values separated by ':'");
+        }
+        return {weights[0], weights[1], weights[2], weights[3]};
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    HarnessSettings harness;
+    try
+    {
+        for (int i = 1; i < argc; i += 2)
+        {
+            const std::string_view arg = argv[i];
+            if (i + 1 == argc)
+            {
+                throw std::invalid_argument("missing value for argument: " + std::string(arg));
+            }
+            const std::string value = argv[i + 1];
+            if (arg == "--sizes")
+                harness.sizes = ParseSizes(value);
+            else if (arg == "--seed")
+                harness.seed = static_cast<uint32_t>(std::stoul(value));
+            else if (arg == "--stat-requests")
+                harness.stat_request_count = std::stoul(value);
+            else if (arg == "--max-route-stops")
+                harness.max_route_stops = std::stoul(value);
+            else if (arg == "--max-map-stops")
+                harness.max_map_stops = std::stoul(value);
+            else if (arg == "--threads")
+                harness.thread_count = std::stoul(value);
+            else if (arg == "--mix")
+                harness.mix = ParseMix(value);
+            else
+                throw std::invalid_argument("unknown argument: " + std::string(arg));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    for (const size_t size : harness.sizes)
+    {
+        RunSize(harness, size, std::cout);
+    }
+}
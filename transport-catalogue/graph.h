@@ -1,5 +1,6 @@
 #pragma once
 
+#include "memory_usage.h"
 #include "ranges.h"
 
 #include <cstdlib>
@@ -38,6 +39,9 @@ namespace graph
         const Edge<Weight> &GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+        // Оценка занимаемой графом динамической памяти: рёбра с названиями и списки смежности
+        size_t GetMemoryUsage() const;
+
     private:
         std::vector<Edge<Weight>> edges_;
         std::vector<IncidenceList> incidence_lists_;
@@ -49,6 +53,21 @@ namespace graph
     {
     }
 
+    template <typename Weight>
+    size_t DirectedWeightedGraph<Weight>::GetMemoryUsage() const
+    {
+        size_t result = sizeof(DirectedWeightedGraph) + memory::VectorBytes(edges_) + memory::VectorBytes(incidence_lists_);
+        for (const auto &edge : edges_)
+        {
+            result += memory::StringBytes(edge.name);
+        }
+        for (const auto &incidence_list : incidence_lists_)
+        {
+            result += memory::VectorBytes(incidence_list);
+        }
+        return result;
+    }
+
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight> &edge)
     {
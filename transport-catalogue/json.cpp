@@ -1,4 +1,10 @@
 #include "json.h"
+#include "memory_usage.h"
+#include "string_scan.h"
+
+#include <charconv>
+#include <iterator>
+
 using namespace std;
 
 namespace json
@@ -305,6 +311,296 @@ namespace json
                 return LoadNumber(input);
             }
         }
+
+        // Разбор документа из удерживаемого буфера без копирования строк
+        class ViewParser
+        {
+        public:
+            explicit ViewParser(std::string_view input) : input_(input) {}
+
+            Node ParseDocument()
+            {
+                Node result = ParseNode();
+                SkipSpaces();
+                return result;
+            }
+
+        private:
+            std::string_view input_;
+            size_t pos_ = 0;
+
+            void SkipSpaces()
+            {
+                while (pos_ < input_.size() && std::isspace(static_cast<unsigned char>(input_[pos_])))
+                {
+                    ++pos_;
+                }
+            }
+
+            // Аналог input >> c: пропускает пробелы и возвращает очередной символ
+            char NextChar(const char *error)
+            {
+                SkipSpaces();
+                if (pos_ == input_.size())
+                {
+                    throw ParsingError(error);
+                }
+                return input_[pos_++];
+            }
+
+            void ExpectWord(std::string_view word)
+            {
+                if (input_.substr(pos_, word.size()) != word)
+                {
+                    throw ParsingError("Expected '"s + std::string(word) + "'"s);
+                }
+                pos_ += word.size();
+                if (pos_ < input_.size() && std::isalnum(static_cast<unsigned char>(input_[pos_])))
+                {
+                    throw ParsingError("Expected end of input after '"s + std::string(word) + "'"s);
+                }
+            }
+
+            Node ParseNode()
+            {
+                const char c = NextChar("Unexpected end of input");
+
+                switch (c)
+                {
+                case 'n':
+                    --pos_;
+                    ExpectWord("null"sv);
+                    return Node{nullptr};
+                case 't':
+                    --pos_;
+                    ExpectWord("true"sv);
+                    return Node{true};
+                case 'f':
+                    --pos_;
+                    ExpectWord("false"sv);
+                    return Node{false};
+                case '[':
+                    return ParseArray();
+                case '{':
+                    return ParseDict();
+                case '"':
+                    return ParseString();
+                default:
+                    --pos_;
+                    return ParseNumber();
+                }
+            }
+
+            Node ParseArray()
+            {
+                Array result;
+
+                for (char c = NextChar("Array parsing error"); c != ']'; c = NextChar("Array parsing error"))
+                {
+                    if (c != ',')
+                    {
+                        --pos_;
+                    }
+                    result.push_back(ParseNode());
+                }
+
+                return Node{std::move(result)};
+            }
+
+            Node ParseDict()
+            {
+                Dict result;
+
+                for (char c = NextChar("Dict parsing error"); c != '}'; c = NextChar("Dict parsing error"))
+                {
+                    if (c == ',')
+                    {
+                        c = NextChar("Dict parsing error");
+                    }
+                    if (c != '"')
+                    {
+                        throw ParsingError("Expected dict key");
+                    }
+
+                    Node key = ParseString();
+                    if (NextChar("Dict parsing error") != ':')
+                    {
+                        throw ParsingError("Expected ':' after dict key");
+                    }
+
+                    // Ключи короче порога SSO (name, latitude, road_distances...) не требуют выделения памяти
+                    auto *owned_key = std::get_if<std::string>(&key.GetValue());
+                    std::string key_str = owned_key ? std::move(*owned_key) : std::string(key.AsStringView());
+                    result.emplace_hint(result.end(), std::move(key_str), ParseNode());
+                }
+
+                return Node{std::move(result)};
+            }
+
+            // Строка без escape-последовательностей возвращается как StringView на входной буфер
+            Node ParseString()
+            {
+                const size_t start = pos_;
+
+                while (true)
+                {
+                    pos_ = FindSpecialChar(input_, pos_);
+                    if (pos_ == std::string_view::npos)
+                    {
+                        throw ParsingError("String parsing error");
+                    }
+                    const char ch = input_[pos_];
+                    if (ch == '"')
+                    {
+                        ++pos_;
+                        return Node{StringView{input_.substr(start, pos_ - 1 - start)}};
+                    }
+                    if (ch == '\\')
+                    {
+                        return Node{ParseEscapedString(start)};
+                    }
+                    if (ch == '\n' || ch == '\r')
+                    {
+                        throw ParsingError("Unexpected end of line"s);
+                    }
+                    // Прочие управляющие символы допускаются внутри строки
+                    ++pos_;
+                }
+            }
+
+            std::string ParseEscapedString(size_t start)
+            {
+                std::string s(input_.substr(start, pos_ - start));
+
+                while (true)
+                {
+                    const size_t special = FindSpecialChar(input_, pos_);
+                    if (special == std::string_view::npos)
+                    {
+                        throw ParsingError("String parsing error");
+                    }
+                    s.append(input_.substr(pos_, special - pos_));
+                    pos_ = special;
+
+                    const char ch = input_[pos_++];
+                    if (ch == '"')
+                    {
+                        return s;
+                    }
+                    if (ch == '\\')
+                    {
+                        if (pos_ == input_.size())
+                        {
+                            throw ParsingError("String parsing error");
+                        }
+                        const char escaped_char = input_[pos_++];
+                        switch (escaped_char)
+                        {
+                        case 'n':
+                            s.push_back('\n');
+                            break;
+                        case 't':
+                            s.push_back('\t');
+                            break;
+                        case 'r':
+                            s.push_back('\r');
+                            break;
+                        case '"':
+                            s.push_back('"');
+                            break;
+                        case '\\':
+                            s.push_back('\\');
+                            break;
+                        default:
+                            throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                        }
+                    }
+                    else if (ch == '\n' || ch == '\r')
+                    {
+                        throw ParsingError("Unexpected end of line"s);
+                    }
+                    else
+                    {
+                        s.push_back(ch);
+                    }
+                }
+            }
+
+            Node ParseNumber()
+            {
+                const size_t start = pos_;
+
+                auto read_digits = [this]
+                {
+                    if (pos_ == input_.size() || !std::isdigit(static_cast<unsigned char>(input_[pos_])))
+                    {
+                        throw ParsingError("A digit is expected"s);
+                    }
+                    while (pos_ < input_.size() && std::isdigit(static_cast<unsigned char>(input_[pos_])))
+                    {
+                        ++pos_;
+                    }
+                };
+                auto peek = [this]
+                {
+                    return pos_ < input_.size() ? input_[pos_] : '\0';
+                };
+
+                if (peek() == '-')
+                {
+                    ++pos_;
+                }
+
+                if (peek() == '0')
+                {
+                    ++pos_;
+                }
+                else
+                {
+                    read_digits();
+                }
+
+                bool is_int = true;
+
+                if (peek() == '.')
+                {
+                    ++pos_;
+                    read_digits();
+                    is_int = false;
+                }
+
+                if (const char ch = peek(); ch == 'e' || ch == 'E')
+                {
+                    ++pos_;
+                    if (const char sign = peek(); sign == '+' || sign == '-')
+                    {
+                        ++pos_;
+                    }
+                    read_digits();
+                    is_int = false;
+                }
+
+                const char *first = input_.data() + start;
+                const char *last = input_.data() + pos_;
+
+                if (is_int)
+                {
+                    int value = 0;
+                    if (auto [ptr, ec] = std::from_chars(first, last, value); ec == std::errc{} && ptr == last)
+                    {
+                        return Node{value};
+                    }
+                    // При переполнении int число разбирается как double
+                }
+
+                double value = 0.0;
+                if (auto [ptr, ec] = std::from_chars(first, last, value); ec == std::errc{} && ptr == last)
+                {
+                    return Node{value};
+                }
+                throw ParsingError("Failed to convert "s + std::string(first, last) + " to number"s);
+            }
+        };
     }
 
     Node::Node(std::nullptr_t)
@@ -342,11 +638,16 @@ namespace json
     {
     }
 
+    Node::Node(StringView value)
+        : value_(value)
+    {
+    }
+
     bool Node::IsInt() const { return std::holds_alternative<int>(value_); }
     bool Node::IsDouble() const { return std::holds_alternative<double>(value_) || std::holds_alternative<int>(value_); }
     bool Node::IsPureDouble() const { return std::holds_alternative<double>(value_); }
     bool Node::IsBool() const { return std::holds_alternative<bool>(value_); }
-    bool Node::IsString() const { return std::holds_alternative<std::string>(value_); }
+    bool Node::IsString() const { return std::holds_alternative<std::string>(value_) || std::holds_alternative<StringView>(value_); }
     bool Node::IsNull() const { return std::holds_alternative<std::nullptr_t>(value_); }
     bool Node::IsArray() const { return std::holds_alternative<Array>(value_); }
     bool Node::IsMap() const { return std::holds_alternative<Dict>(value_); }
@@ -374,11 +675,18 @@ namespace json
         return std::get<bool>(value_);
     }
 
-    const std::string &Node::AsString() const
+    std::string Node::AsString() const
     {
-        if (!IsString())
-            throw std::logic_error("wrong type");
-        return std::get<std::string>(value_);
+        return std::string(AsStringView());
+    }
+
+    std::string_view Node::AsStringView() const
+    {
+        if (const auto *view = std::get_if<StringView>(&value_))
+            return view->Get();
+        if (const auto *str = std::get_if<std::string>(&value_))
+            return *str;
+        throw std::logic_error("wrong type");
     }
 
     const Array &Node::AsArray() const
@@ -407,12 +715,15 @@ namespace json
 
     bool Node::operator==(const Node &rhs) const
     {
+        // Строка-представление равна владеющей строке с тем же содержимым
+        if (IsString() && rhs.IsString())
+            return AsStringView() == rhs.AsStringView();
         return value_ == rhs.value_;
     }
 
     bool Node::operator!=(const Node &rhs) const
     {
-        return !(value_ == rhs.value_);
+        return !(*this == rhs);
     }
 
     Document::Document(Node root)
@@ -420,11 +731,53 @@ namespace json
     {
     }
 
+    Document::Document(Node root, std::shared_ptr<const std::string> source)
+        : root_(std::move(root)), source_(std::move(source))
+    {
+    }
+
     const Node &Document::GetRoot() const
     {
         return root_;
     }
 
+    namespace
+    {
+        size_t NodeHeapBytes(const Node &node)
+        {
+            if (node.IsArray())
+            {
+                const Array &array = node.AsArray();
+                size_t result = memory::VectorBytes(array);
+                for (const Node &item : array)
+                {
+                    result += NodeHeapBytes(item);
+                }
+                return result;
+            }
+            if (node.IsMap())
+            {
+                const Dict &dict = node.AsMap();
+                size_t result = memory::TreeNodesBytes(dict);
+                for (const auto &[key, value] : dict)
+                {
+                    result += memory::StringBytes(key) + NodeHeapBytes(value);
+                }
+                return result;
+            }
+            if (const auto *str = std::get_if<std::string>(&node.GetValue()))
+            {
+                return memory::StringBytes(*str);
+            }
+            return 0;
+        }
+    }
+
+    size_t Document::GetMemoryUsage() const
+    {
+        return sizeof(Document) + NodeHeapBytes(root_) + (source_ ? sizeof(std::string) + source_->capacity() : 0);
+    }
+
     bool Document::operator==(const Document &rhs) const
     {
         return root_ == rhs.root_;
@@ -440,97 +793,267 @@ namespace json
         return Document{LoadNode(input)};
     }
 
-    template <typename Value>
-    void PrintValue(const Value &value, std::ostream &out)
+    Document LoadView(std::string input)
     {
-        out << value;
+        // Буфер размещается в куче один раз, чтобы адреса символов не менялись при перемещении документа
+        auto source = std::make_shared<const std::string>(std::move(input));
+        Node root = ViewParser(*source).ParseDocument();
+        return Document{std::move(root), std::move(source)};
     }
 
-    void PrintValue(std::nullptr_t, std::ostream &out)
+    Document LoadView(std::istream &input)
     {
-        out << "null"sv;
+        return LoadView(std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()));
     }
 
-    void PrintValue(bool value, std::ostream &out)
+    namespace
     {
-        out << (value ? "true" : "false");
+        // Текст первого документа потока. Глубина вложенности считается вне строк, поэтому
+        // скобки внутри строк не завершают документ; корневое значение-скаляр заканчивается пробелом
+        std::string ReadDocumentText(std::istream &input)
+        {
+            using Traits = std::char_traits<char>;
+            std::streambuf &buf = *input.rdbuf();
+            std::string text;
+            size_t depth = 0;
+            bool in_string = false;
+            bool escaped = false;
+
+            for (int next = buf.sbumpc(); next != Traits::eof(); next = buf.sbumpc())
+            {
+                const char c = Traits::to_char_type(next);
+                const bool space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+                if (text.empty() && space)
+                {
+                    continue;
+                }
+                if (in_string)
+                {
+                    text.push_back(c);
+                    if (escaped)
+                    {
+                        escaped = false;
+                    }
+                    else if (c == '\\')
+                    {
+                        escaped = true;
+                    }
+                    else if (c == '"')
+                    {
+                        in_string = false;
+                        if (depth == 0)
+                        {
+                            return text;
+                        }
+                    }
+                    continue;
+                }
+                if (depth == 0 && space)
+                {
+                    return text;
+                }
+                text.push_back(c);
+                if (c == '"')
+                {
+                    in_string = true;
+                }
+                else if (c == '{' || c == '[')
+                {
+                    ++depth;
+                }
+                else if ((c == '}' || c == ']') && depth > 0 && --depth == 0)
+                {
+                    return text;
+                }
+            }
+
+            input.setstate(std::ios::eofbit);
+            return text;
+        }
     }
 
-    void PrintValue(const std::string &value, std::ostream &out)
+    Document LoadViewNext(std::istream &input)
+    {
+        return LoadView(ReadDocumentText(input));
+    }
+
+    namespace
     {
-        out << "\""sv;
+        void PrintNode(const Node &node, const PrintContext &ctx);
 
-        for (const char &c : value)
+        void PrintValue(std::nullptr_t, const PrintContext &ctx)
         {
-            if (c == '\n')
+            ctx.out.Write("null"sv);
+        }
+
+        void PrintValue(bool value, const PrintContext &ctx)
+        {
+            ctx.out.Write(value ? "true"sv : "false"sv);
+        }
+
+        void PrintValue(int value, const PrintContext &ctx)
+        {
+            ctx.out.WriteInt(value);
+        }
+
+        void PrintValue(double value, const PrintContext &ctx)
+        {
+            ctx.out.WriteDouble(value);
+        }
+
+        void PrintValue(const std::string &value, const PrintContext &ctx)
+        {
+            PrintString(value, ctx.out);
+        }
+
+        void PrintValue(const StringView &value, const PrintContext &ctx)
+        {
+            PrintString(value.Get(), ctx.out);
+        }
+
+        void PrintValue(const Array &array, const PrintContext &ctx)
+        {
+            if (ctx.IsCompact() || array.empty())
             {
-                out << "\\n"sv;
-                continue;
+                ctx.out.Put('[');
+                bool first = true;
+                for (const auto &item : array)
+                {
+                    if (!first)
+                    {
+                        ctx.out.Put(',');
+                    }
+                    first = false;
+                    PrintNode(item, ctx);
+                }
+                ctx.out.Put(']');
+                return;
             }
-            if (c == '\r')
+
+            ctx.out.Write("[\n"sv);
+            const PrintContext inner = ctx.Indented();
+            bool first = true;
+            for (const auto &item : array)
             {
-                out << "\\r"sv;
-                continue;
+                if (!first)
+                {
+                    ctx.out.Write(",\n"sv);
+                }
+                first = false;
+                inner.PrintIndent();
+                PrintNode(item, inner);
             }
-            if (c == '\"')
-                out << "\\"sv;
-            if (c == '\t')
+            ctx.out.Put('\n');
+            ctx.PrintIndent();
+            ctx.out.Put(']');
+        }
+
+        void PrintValue(const Dict &dict, const PrintContext &ctx)
+        {
+            if (ctx.IsCompact() || dict.empty())
             {
-                out << "\\t"sv;
-                continue;
+                ctx.out.Put('{');
+                bool first = true;
+                for (const auto &[key, value] : dict)
+                {
+                    if (!first)
+                    {
+                        ctx.out.Put(',');
+                    }
+                    first = false;
+                    PrintString(key, ctx.out);
+                    ctx.out.Put(':');
+                    PrintNode(value, ctx);
+                }
+                ctx.out.Put('}');
+                return;
             }
-            if (c == '\\')
-                out << "\\"sv;
-            out << c;
+
+            ctx.out.Write("{\n"sv);
+            const PrintContext inner = ctx.Indented();
+            bool first = true;
+            for (const auto &[key, value] : dict)
+            {
+                if (!first)
+                {
+                    ctx.out.Write(",\n"sv);
+                }
+                first = false;
+                inner.PrintIndent();
+                PrintString(key, ctx.out);
+                ctx.out.Write(": "sv);
+                PrintNode(value, inner);
+            }
+            ctx.out.Put('\n');
+            ctx.PrintIndent();
+            ctx.out.Put('}');
         }
 
-        out << "\""sv;
+        void PrintNode(const Node &node, const PrintContext &ctx)
+        {
+            std::visit(
+                [&ctx](const auto &value)
+                { PrintValue(value, ctx); },
+                node.GetValue());
+        }
     }
 
-    void PrintNode(const Node &node, std::ostream &out)
+    void PrintString(std::string_view value, io::OutputBuffer &output)
     {
-        std::visit(
-            [&out](const auto &value)
-            { PrintValue(value, out); },
-            node.GetValue());
+        output.Put('"');
+        PrintStringContent(value, output);
+        output.Put('"');
     }
 
-    void PrintValue(const Array &array, std::ostream &out)
+    void PrintStringContent(std::string_view value, io::OutputBuffer &output)
     {
-        out << '[';
-        bool first = true;
-        for (const auto &item : array)
+        // Символы без экранирования выводим сразу целыми отрезками,
+        // границы отрезков ищутся векторизованно (см. FindSpecialChar)
+        size_t run_start = 0;
+        for (size_t i = FindSpecialChar(value); i != std::string_view::npos; i = FindSpecialChar(value, i + 1))
         {
-            if (!first)
+            std::string_view escaped;
+            switch (value[i])
             {
-                out << ',';
+            case '\n':
+                escaped = "\\n"sv;
+                break;
+            case '\r':
+                escaped = "\\r"sv;
+                break;
+            case '\t':
+                escaped = "\\t"sv;
+                break;
+            case '"':
+                escaped = "\\\""sv;
+                break;
+            case '\\':
+                escaped = "\\\\"sv;
+                break;
+            default:
+                // Прочие управляющие символы выводятся как есть
+                continue;
             }
-            first = false;
-            PrintNode(item, out);
+            output.Write(value.substr(run_start, i - run_start));
+            output.Write(escaped);
+            run_start = i + 1;
         }
-        out << ']';
+        output.Write(value.substr(run_start));
     }
 
-    void PrintValue(const Dict &dict, std::ostream &out)
+    void PrintNode(const Node &node, io::OutputBuffer &output)
     {
-        out << '{';
-        bool first = true;
-        for (const auto &[key, value] : dict)
-        {
-            if (!first)
-            {
-                out << ',';
-            }
-            first = false;
-            PrintValue(key, out);
-            out << ':';
-            PrintNode(value, out);
-        }
-        out << '}';
+        PrintNode(node, PrintContext{output, 0, 0});
+    }
+
+    void Print(const Document &doc, io::OutputBuffer &output, int indent_step)
+    {
+        PrintNode(doc.GetRoot(), PrintContext{output, indent_step, 0});
     }
 
     void Print(const Document &doc, std::ostream &output)
     {
-        PrintNode(doc.GetRoot(), output);
+        io::OutputBuffer buffer(output);
+        Print(doc, buffer);
     }
 } // namespace json
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "output_buffer.h"
+
 #include <iostream>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 #include <cctype>
@@ -22,7 +26,22 @@ namespace json
         using runtime_error::runtime_error;
     };
 
-    class Node final : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>
+    // Строка, ссылающаяся на входной буфер документа без копирования (см. LoadView).
+    // Конструктор явный, чтобы строковые литералы по-прежнему превращались в std::string
+    class StringView
+    {
+    public:
+        explicit StringView(std::string_view value) : value_(value) {}
+
+        std::string_view Get() const { return value_; }
+
+        bool operator==(const StringView &rhs) const { return value_ == rhs.value_; }
+
+    private:
+        std::string_view value_;
+    };
+
+    class Node final : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string, StringView>
     {
     public:
         using variant::variant;
@@ -35,6 +54,7 @@ namespace json
         Node(double value);
         Node(bool value);
         Node(std::string value);
+        Node(StringView value);
         Node(Array array);
         Node(Dict map);
 
@@ -50,7 +70,10 @@ namespace json
         int AsInt() const;
         double AsDouble() const;
         bool AsBool() const;
-        const std::string &AsString() const;
+        // Копия строки любого хранения, в том числе представления из LoadView;
+        // без копирования строка доступна через AsStringView
+        std::string AsString() const;
+        std::string_view AsStringView() const;
         const Array &AsArray() const;
         const Dict &AsMap() const;
 
@@ -68,29 +91,49 @@ namespace json
     {
     public:
         explicit Document(Node root);
+        Document(Node root, std::shared_ptr<const std::string> source);
         const Node &GetRoot() const;
 
+        // Оценка занимаемой документом динамической памяти: узлы, строки и входной буфер
+        size_t GetMemoryUsage() const;
+
         bool operator==(const Document &rhs) const;
         bool operator!=(const Document &rhs) const;
 
     private:
         Node root_;
+        // Входной буфер, на который ссылаются строки-представления
+        std::shared_ptr<const std::string> source_;
     };
 
     Document Load(std::istream &input);
 
-    // Контекст вывода, хранит ссылку на поток вывода и текущий отступ
+    // Разбор без копирования строк: документ удерживает входной буфер, строки без
+    // escape-последовательностей хранятся как StringView на него, остальные материализуются
+    Document LoadView(std::string input);
+    Document LoadView(std::istream &input);
+    // Читает из потока один документ до его конца и разбирает как LoadView;
+    // всё, что идёт в потоке после документа, остаётся непрочитанным
+    Document LoadViewNext(std::istream &input);
+
+    // Контекст вывода, хранит ссылку на буфер вывода и текущий отступ.
+    // Нулевой шаг отступа означает компактный вывод без отступов и переводов строк
     struct PrintContext
     {
-        std::ostream &out;
+        io::OutputBuffer &out;
         int indent_step = 4;
         int indent = 0;
 
+        bool IsCompact() const
+        {
+            return indent_step == 0;
+        }
+
         void PrintIndent() const
         {
             for (int i = 0; i < indent; ++i)
             {
-                out.put(' ');
+                out.Put(' ');
             }
         }
 
@@ -103,4 +146,16 @@ namespace json
 
     void Print(const Document &doc, std::ostream &output);
 
+    // Выводит документ в буфер; indent_step == 0 задаёт компактный режим
+    void Print(const Document &doc, io::OutputBuffer &output, int indent_step = 0);
+
+    // Выводит отдельный узел в компактном виде
+    void PrintNode(const Node &node, io::OutputBuffer &output);
+
+    // Выводит строку в кавычках с экранированием спецсимволов
+    void PrintString(std::string_view value, io::OutputBuffer &output);
+
+    // То же без кавычек: строку можно экранировать по частям, разрезая её в любом месте
+    void PrintStringContent(std::string_view value, io::OutputBuffer &output);
+
 } // namespace json
@@ -1,418 +1,877 @@
-#include "json_reader.h"
-
-#include <algorithm>
-#include <cassert>
-#include <iterator>
-#include <iostream>
-
-const json::Node &JsonReader::GetBaseRequests() const
-{
-    if (!doc_.GetRoot().AsMap().count("base_requests"))
-        return ntr_;
-    return doc_.GetRoot().AsMap().at("base_requests");
-}
-
-const json::Node &JsonReader::GetStatRequests() const
-{
-    if (!doc_.GetRoot().AsMap().count("stat_requests"))
-        return ntr_;
-    return doc_.GetRoot().AsMap().at("stat_requests");
-}
-
-const json::Node &JsonReader::GetRenderSettings() const
-{
-    if (!doc_.GetRoot().AsMap().count("render_settings"))
-        return ntr_;
-    return doc_.GetRoot().AsMap().at("render_settings");
-}
-
-const json::Node &JsonReader::GetRoutingSettings() const
-{
-    if (!doc_.GetRoot().AsMap().count("routing_settings"))
-        return ntr_;
-    return doc_.GetRoot().AsMap().at("routing_settings");
-}
-
-void JsonReader::AddCatalogue(transport_catalogue::TransportCatalogue &catalogue)
-{
-    const json::Array &array = GetBaseRequests().AsArray();
-
-    std::vector<json::Node> buses_v;
-    buses_v.reserve(array.size());
-    std::vector<json::Node> stops_v;
-    stops_v.reserve(array.size());
-
-    for (const auto &request : array)
-    {
-        const auto &base_request = request.AsMap();
-        const auto &type = base_request.at("type").AsString();
-
-        if (type == "Stop")
-        {
-            auto [stop_name, coordinates, stop_distances] = ParseStopWithDistances(base_request);
-            catalogue.AddStop(stop_name, coordinates);
-            stops_v.push_back(request);
-        }
-
-        if (type == "Bus")
-        {
-            buses_v.push_back(request);
-        }
-    }
-
-    for (const auto &request : stops_v)
-    {
-        const auto &base_request = request.AsMap();
-        auto [stop_from_name, coordinates, stop_distances] = ParseStopWithDistances(base_request);
-
-        for (auto &[stop_to_name, dist] : stop_distances)
-        {
-            auto stop_from = catalogue.FindStop(std::string(stop_from_name));
-            auto stop_to = catalogue.FindStop(std::string(stop_to_name));
-            catalogue.AddDistance(stop_from, stop_to, dist);
-        }
-    }
-
-    for (const auto &request : buses_v)
-    {
-        const auto &base_requset = request.AsMap();
-        auto [bus_number, stops, circular_route] = ParseBus(base_requset, catalogue);
-        catalogue.AddRoute(bus_number, stops, circular_route);
-    }
-}
-
-transport_catalogue::ParseStops JsonReader::ParseStopWithDistances(const json::Dict &request_map) const
-{
-    transport_catalogue::ParseStops result;
-    result.name_stop = request_map.at("name").AsString();
-    result.coordinates = {request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble()};
-    std::map<std::string_view, int> stop_distances;
-    auto &distances = request_map.at("road_distances").AsMap();
-
-    for (auto &[stop_to_name, distance] : distances)
-    {
-        stop_distances.emplace(stop_to_name, distance.AsInt());
-    }
-
-    result.stops_and_distances = stop_distances;
-
-    return result;
-}
-
-transport_catalogue::ParseBus JsonReader::ParseBus(const json::Dict &request_map, transport_catalogue::TransportCatalogue &catalogue) const
-{
-    transport_catalogue::ParseBus result;
-    result.name_bus = request_map.at("name").AsString();
-    std::vector<const transport_catalogue::Stop *> stops;
-
-    for (auto &stop : request_map.at("stops").AsArray())
-    {
-        stops.push_back(catalogue.FindStop(stop.AsString()));
-    }
-
-    result.stops = stops;
-    result.is_roundtrip = request_map.at("is_roundtrip").AsBool();
-
-    return result;
-}
-
-void JsonReader::PrintFunction(const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router) const
-{
-    json::Array result;
-    const json::Array array = GetStatRequests().AsArray();
-
-    for (const auto &request : array)
-    {
-        const auto &base_request = request.AsMap();
-        const auto &type = base_request.at("type").AsString();
-
-        if (type == "Stop")
-        {
-            result.push_back(PrintStop(base_request, catalogue).AsMap());
-        }
-
-        if (type == "Bus")
-        {
-            result.push_back(PrintBus(base_request, catalogue).AsMap());
-        }
-
-        if (type == "Map")
-        {
-            result.push_back(PrintMap(base_request, catalogue).AsMap());
-        }
-
-        if (type == "Route")
-        {
-            result.push_back(PrintRouting(base_request, router).AsMap());
-        }
-    }
-    json::Print(json::Document{result}, std::cout);
-}
-
-const json::Node JsonReader::PrintBus(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue) const
-{
-    json::Node result;
-    const std::string &bus_name = request_map.at("name").AsString();
-    const int id = request_map.at("id").AsInt();
-
-    if (!catalogue.FindBus(bus_name))
-    {
-        result = json::Builder{}
-                     .StartDict()
-                     .Key("request_id")
-                     .Value(id)
-                     .Key("error_message")
-                     .Value("not found")
-                     .EndDict()
-                     .Build();
-    }
-    else
-    {
-        const auto &result_info = GetBusStat(bus_name, catalogue);
-        result = json::Builder{}
-                     .StartDict()
-                     .Key("request_id")
-                     .Value(id)
-                     .Key("curvature")
-                     .Value(result_info->curvature)
-                     .Key("route_length")
-                     .Value(result_info->route_length)
-                     .Key("stop_count")
-                     .Value(static_cast<int>(result_info->stops_on_route))
-                     .Key("unique_stop_count")
-                     .Value(static_cast<int>(result_info->unique_stops))
-                     .EndDict()
-                     .Build();
-    }
-
-    return result;
-}
-
-const json::Node JsonReader::PrintStop(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue) const
-{
-    json::Node result;
-    const std::string &stop_name = request_map.at("name").AsString();
-    const int id = request_map.at("id").AsInt();
-
-    if (!catalogue.FindStop(stop_name))
-    {
-        result = json::Builder{}
-                     .StartDict()
-                     .Key("request_id")
-                     .Value(id)
-                     .Key("error_message")
-                     .Value("not found")
-                     .EndDict()
-                     .Build();
-    }
-    else
-    {
-        json::Array buses;
-
-        for (auto &bus : GetBusesByStop(stop_name, catalogue))
-        {
-            buses.push_back(bus);
-        }
-
-        result = json::Builder{}
-                     .StartDict()
-                     .Key("request_id")
-                     .Value(id)
-                     .Key("buses")
-                     .Value(buses)
-                     .EndDict()
-                     .Build();
-    }
-
-    return result;
-}
-
-const json::Node JsonReader::PrintMap(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue) const
-{
-    json::Node result;
-
-    const int id = request_map.at("id").AsInt();
-    std::ostringstream strm;
-    svg::Document map = RenderMap(catalogue);
-    map.Render(strm);
-    result = json::Builder{}
-                 .StartDict()
-                 .Key("request_id")
-                 .Value(id)
-                 .Key("map")
-                 .Value(strm.str())
-                 .EndDict()
-                 .Build();
-
-    return result;
-}
-
-renderer::MapRenderer JsonReader::ParseRenderSettings(const json::Dict &request_map) const
-{
-    renderer::RenderSettings render_settings;
-    render_settings.width = request_map.at("width").AsDouble();
-    render_settings.height = request_map.at("height").AsDouble();
-    render_settings.padding = request_map.at("padding").AsDouble();
-    render_settings.stop_radius = request_map.at("stop_radius").AsDouble();
-    render_settings.line_width = request_map.at("line_width").AsDouble();
-    render_settings.bus_label_font_size = request_map.at("bus_label_font_size").AsInt();
-    const json::Array &bus_label_offset = request_map.at("bus_label_offset").AsArray();
-    render_settings.bus_label_offset = {bus_label_offset[0].AsDouble(), bus_label_offset[1].AsDouble()};
-    render_settings.stop_label_font_size = request_map.at("stop_label_font_size").AsInt();
-    const json::Array &stop_label_offset = request_map.at("stop_label_offset").AsArray();
-    render_settings.stop_label_offset = {stop_label_offset[0].AsDouble(), stop_label_offset[1].AsDouble()};
-    render_settings.underlayer_width = request_map.at("underlayer_width").AsDouble();
-
-    const auto &underlayer_color_json = request_map.at("underlayer_color");
-    if (underlayer_color_json.IsString())
-    {
-        render_settings.underlayer_color = underlayer_color_json.AsString();
-    }
-    else if (underlayer_color_json.IsArray())
-    {
-        const json::Array &underlayer_color = underlayer_color_json.AsArray();
-        if (underlayer_color.size() == 3)
-        {
-            render_settings.underlayer_color = svg::Rgb(static_cast<uint8_t>(underlayer_color[0].AsInt()), static_cast<uint8_t>(underlayer_color[1].AsInt()), static_cast<uint8_t>(underlayer_color[2].AsInt()));
-        }
-        else if (underlayer_color.size() == 4)
-        {
-            render_settings.underlayer_color = svg::Rgba(static_cast<uint8_t>(underlayer_color[0].AsInt()), static_cast<uint8_t>(underlayer_color[1].AsInt()), static_cast<uint8_t>(underlayer_color[2].AsInt()), underlayer_color[3].AsDouble());
-        }
-        else
-        {
-            throw std::logic_error("wrong underlayer colortype");
-        }
-    }
-    else
-    {
-        throw std::logic_error("wrong underlayer color");
-    }
-
-    const json::Array &color_palette = request_map.at("color_palette").AsArray();
-    for (const auto &color_element : color_palette)
-    {
-        if (color_element.IsString())
-        {
-            render_settings.color_palette.push_back(color_element.AsString());
-        }
-        else if (color_element.IsArray())
-        {
-            const json::Array &color_type = color_element.AsArray();
-            if (color_type.size() == 3)
-            {
-                render_settings.color_palette.push_back(svg::Rgb(static_cast<uint8_t>(color_type[0].AsInt()), static_cast<uint8_t>(color_type[1].AsInt()), static_cast<uint8_t>(color_type[2].AsInt())));
-            }
-            else if (color_type.size() == 4)
-            {
-                render_settings.color_palette.push_back(svg::Rgba(static_cast<uint8_t>(color_type[0].AsInt()), static_cast<uint8_t>(color_type[1].AsInt()), static_cast<uint8_t>(color_type[2].AsInt()), color_type[3].AsDouble()));
-            }
-            else
-            {
-                throw std::logic_error("wrong color palette type");
-            }
-        }
-        else
-        {
-            throw std::logic_error("wrong color palette");
-        }
-    }
-    return render_settings;
-}
-
-const json::Node JsonReader::PrintRouting(const json::Dict &request_map, const transport_catalogue::Router &router) const
-{
-    json::Node result;
-    const int id = request_map.at("id").AsInt();
-    const std::string_view stop_from = request_map.at("from").AsString();
-    const std::string_view stop_to = request_map.at("to").AsString();
-    const auto &graph_router_info = router.FindInfoRoute(stop_from, stop_to);
-
-    if (!graph_router_info.route_setting)
-    {
-        result = json::Builder{}
-                     .StartDict()
-                     .Key("request_id")
-                     .Value(id)
-                     .Key("error_message")
-                     .Value("not found")
-                     .EndDict()
-                     .Build();
-    }
-    else
-    {
-        json::Array items;
-        double total_time = 0.0;
-        items.reserve(graph_router_info.route_setting.value().edges.size());
-        for (auto &edge : graph_router_info.edges)
-        {
-            if (edge.quality == 0)
-            {
-                items.emplace_back(json::Node(json::Builder{}
-                                                  .StartDict()
-                                                  .Key("stop_name")
-                                                  .Value(edge.name)
-                                                  .Key("time")
-                                                  .Value(edge.weight)
-                                                  .Key("type")
-                                                  .Value("Wait")
-                                                  .EndDict()
-                                                  .Build()));
-
-                total_time += edge.weight;
-            }
-            else
-            {
-                items.emplace_back(json::Node(json::Builder{}
-                                                  .StartDict()
-                                                  .Key("bus")
-                                                  .Value(edge.name)
-                                                  .Key("span_count")
-                                                  .Value(static_cast<int>(edge.quality))
-                                                  .Key("time")
-                                                  .Value(edge.weight)
-                                                  .Key("type")
-                                                  .Value("Bus")
-                                                  .EndDict()
-                                                  .Build()));
-
-                total_time += edge.weight;
-            }
-        }
-
-        result = json::Builder{}
-                     .StartDict()
-                     .Key("request_id")
-                     .Value(id)
-                     .Key("total_time")
-                     .Value(total_time)
-                     .Key("items")
-                     .Value(items)
-                     .EndDict()
-                     .Build();
-    }
-
-    return result;
-}
-
-std::optional<transport_catalogue::InfoRoute> JsonReader::GetBusStat(const std::string_view &bus_name, const transport_catalogue::TransportCatalogue &catalogue) const
-{
-    return catalogue.InformationRoute(std::string(bus_name));
-}
-
-const std::set<std::string> JsonReader::GetBusesByStop(const std::string_view &stop_name, const transport_catalogue::TransportCatalogue &catalogue) const
-{
-    return catalogue.FindStop(std::string(stop_name))->passing_buses;
-}
-
-svg::Document JsonReader::RenderMap(const transport_catalogue::TransportCatalogue &catalogue) const
-{
-    renderer::MapRenderer result(ParseRenderSettings(GetRenderSettings().AsMap()));
-    return result.GetDocumentSVG(catalogue.GetSortedBuses());
-}
-
-transport_catalogue::RouteSettings JsonReader::FillRoutingSettings(const json::Node &settings) const
-{
-    transport_catalogue::RouteSettings routing_settings{settings.AsMap().at("bus_wait_time").AsInt(), settings.AsMap().at("bus_velocity").AsDouble()};
-    return routing_settings;
+#include "json_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <iterator>
+#include <iostream>
+
+const json::Node &JsonReader::GetBaseRequests() const
+{
+    if (!doc_.GetRoot().AsMap().count("base_requests"))
+        return ntr_;
+    return doc_.GetRoot().AsMap().at("base_requests");
+}
+
+const json::Node &JsonReader::GetStatRequests() const
+{
+    if (!doc_.GetRoot().AsMap().count("stat_requests"))
+        return ntr_;
+    return doc_.GetRoot().AsMap().at("stat_requests");
+}
+
+size_t JsonReader::GetDocumentMemoryUsage() const
+{
+    return doc_.GetMemoryUsage();
+}
+
+bool JsonReader::HasStatRequest(std::string_view type) const
+{
+    const json::Node &requests = GetStatRequests();
+    if (!requests.IsArray())
+        return false;
+
+    for (const auto &request : requests.AsArray())
+    {
+        const auto &request_map = request.AsMap();
+        if (const auto it = request_map.find("type"); it != request_map.end() && it->second.AsStringView() == type)
+            return true;
+    }
+    return false;
+}
+
+const json::Node &JsonReader::GetRenderSettings() const
+{
+    if (!doc_.GetRoot().AsMap().count("render_settings"))
+        return ntr_;
+    return doc_.GetRoot().AsMap().at("render_settings");
+}
+
+const json::Node &JsonReader::GetRoutingSettings() const
+{
+    if (!doc_.GetRoot().AsMap().count("routing_settings"))
+        return ntr_;
+    return doc_.GetRoot().AsMap().at("routing_settings");
+}
+
+void JsonReader::SetThreadPool(parallel::ThreadPool *pool)
+{
+    pool_ = pool;
+}
+
+void JsonReader::SetResponseCache(cache::ResponseCache *cache)
+{
+    cache_ = cache;
+}
+
+void JsonReader::SetRunStats(stats::RunStats *stats)
+{
+    stats_ = stats;
+}
+
+void JsonReader::SetMapStreaming(bool enabled)
+{
+    stream_map_ = enabled;
+}
+
+bool JsonReader::IsStreamedMap(const json::Dict &request_map) const
+{
+    return stream_map_ && request_map.at("type").AsStringView() == "Map" && !request_map.count("bbox") && !request_map.count("tile");
+}
+
+bool JsonReader::UsesRenderedMap(const json::Dict &request_map) const
+{
+    const auto type = request_map.at("type").AsStringView();
+    return type == "RouteMap" || (!stream_map_ && type == "Map" && !request_map.count("bbox") && !request_map.count("tile"));
+}
+
+void JsonReader::AddCatalogue(transport_catalogue::TransportCatalogue &catalogue)
+{
+    const json::Array &array = GetBaseRequests().AsArray();
+
+    // Этап 1: раскладываем запросы по типам, не копируя узлы
+    std::vector<const json::Dict *> stop_requests;
+    std::vector<const json::Dict *> bus_requests;
+    stop_requests.reserve(array.size());
+    bus_requests.reserve(array.size());
+
+    for (const auto &request : array)
+    {
+        const auto &base_request = request.AsMap();
+        const auto type = base_request.at("type").AsStringView();
+
+        if (type == "Stop")
+            stop_requests.push_back(&base_request);
+
+        if (type == "Bus")
+            bus_requests.push_back(&base_request);
+    }
+
+    // Этап 2: каждая остановка разбирается один раз, части массива — параллельно
+    std::vector<transport_catalogue::ParseStops> stops(stop_requests.size());
+    ForEachChunk(stop_requests.size(), [&](size_t begin, size_t end)
+                 {
+        for (size_t i = begin; i < end; ++i)
+        {
+            stops[i] = ParseStopWithDistances(*stop_requests[i]);
+        } });
+
+    // Этап 3: индекс имён остановок строится последовательно
+    for (const auto &stop : stops)
+    {
+        catalogue.AddStop(stop.name_stop, stop.coordinates);
+    }
+
+    // Этап 4: расстояния и остановки маршрутов разрешаются параллельно, каталог только читается
+    struct Distance
+    {
+        const transport_catalogue::Stop *from;
+        const transport_catalogue::Stop *to;
+        int distance;
+    };
+    std::vector<std::vector<Distance>> distances(stops.size());
+    ForEachChunk(stops.size(), [&](size_t begin, size_t end)
+                 {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const transport_catalogue::Stop *stop_from = catalogue.FindStop(stops[i].name_stop);
+            distances[i].reserve(stops[i].stops_and_distances.size());
+            for (const auto &[stop_to_name, dist] : stops[i].stops_and_distances)
+            {
+                distances[i].push_back({stop_from, catalogue.FindStop(stop_to_name), dist});
+            }
+        } });
+
+    std::vector<transport_catalogue::ParseBus> buses(bus_requests.size());
+    ForEachChunk(bus_requests.size(), [&](size_t begin, size_t end)
+                 {
+        for (size_t i = begin; i < end; ++i)
+        {
+            buses[i] = ParseBus(*bus_requests[i], catalogue);
+        } });
+
+    // Этап 5: результаты переносятся в каталог
+    for (const auto &stop_distances : distances)
+    {
+        for (const auto &[from, to, distance] : stop_distances)
+        {
+            catalogue.AddDistance(from, to, distance);
+        }
+    }
+
+    for (const auto &[bus_number, bus_stops, circular_route] : buses)
+    {
+        catalogue.AddRoute(bus_number, bus_stops, circular_route);
+    }
+}
+
+void JsonReader::ForEachChunk(size_t count, const std::function<void(size_t, size_t)> &body) const
+{
+    static constexpr size_t CHUNK_SIZE = 512;
+
+    if (pool_ && pool_->GetThreadCount() > 1)
+    {
+        pool_->ParallelFor(count, CHUNK_SIZE, body);
+    }
+    else
+    {
+        body(0, count);
+    }
+}
+
+transport_catalogue::ParseStops JsonReader::ParseStopWithDistances(const json::Dict &request_map) const
+{
+    transport_catalogue::ParseStops result;
+    result.name_stop = request_map.at("name").AsStringView();
+    result.coordinates = {request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble()};
+    auto &distances = request_map.at("road_distances").AsMap();
+    result.stops_and_distances.reserve(distances.size());
+
+    for (auto &[stop_to_name, distance] : distances)
+    {
+        result.stops_and_distances.emplace_back(stop_to_name, distance.AsInt());
+    }
+
+    return result;
+}
+
+transport_catalogue::ParseBus JsonReader::ParseBus(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue) const
+{
+    transport_catalogue::ParseBus result;
+    result.name_bus = request_map.at("name").AsStringView();
+    const json::Array &stops = request_map.at("stops").AsArray();
+    result.stops.reserve(stops.size());
+
+    for (auto &stop : stops)
+    {
+        result.stops.push_back(catalogue.FindStop(stop.AsStringView()));
+    }
+
+    result.is_roundtrip = request_map.at("is_roundtrip").AsBool();
+
+    return result;
+}
+
+void JsonReader::PrintFunction(const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, io::OutputBuffer &output) const
+{
+    const json::Array &array = GetStatRequests().AsArray();
+
+    // Каждый ответ сериализуется прямо в буфер вывода, буфер сбрасывается крупными кусками
+    json::StreamBuilder builder(output);
+    builder.StartArray();
+
+    if (pool_ && pool_->GetThreadCount() > 1)
+    {
+        PrintParallel(array, catalogue, router, builder);
+    }
+    else
+    {
+        for (const auto &request : array)
+        {
+            PrintRequest(request.AsMap(), catalogue, router, builder);
+        }
+    }
+
+    builder.EndArray().Finish();
+    output.Flush();
+}
+
+void JsonReader::PrintResponse(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, io::OutputBuffer &output) const
+{
+    json::StreamBuilder builder(output);
+    PrintRequest(request_map, catalogue, router, builder);
+}
+
+void JsonReader::PrintParallel(const json::Array &requests, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const
+{
+    // Запросы выполняются в пуле по одному на задачу, поэтому тяжёлые Map и лёгкие Stop
+    // распределяются между потоками перехватом задач. Одновременно в работе не больше window
+    // запросов: ответы лежат в кольцевом буфере и выводятся строго в порядке запросов.
+    // Карта при потоковом выводе в буфере не собирается: её в свою очередь выводит вызывающий поток
+    struct Slot
+    {
+        std::string body;
+        std::exception_ptr error;
+        bool ready = false;
+        bool direct = false;
+    };
+
+    // Внутри задач карта отрисовывалась бы без пула (см. GetRenderedMap), поэтому отрисовываем её заранее
+    if (std::any_of(requests.begin(), requests.end(), [this](const json::Node &request)
+                    { return UsesRenderedMap(request.AsMap()); }))
+    {
+        PrerenderMap(catalogue);
+    }
+
+    const size_t window = pool_->GetThreadCount() * 8;
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    size_t submitted = 0;
+    size_t finished = 0;
+
+    auto submit = [&](size_t index)
+    {
+        if (IsStreamedMap(requests[index].AsMap()))
+        {
+            std::lock_guard lock(mutex);
+            Slot &slot = slots[index % window];
+            slot.direct = true;
+            slot.ready = true;
+            ++finished;
+            return;
+        }
+
+        pool_->Submit([&, index]
+                      {
+            Slot &slot = slots[index % window];
+            try
+            {
+                io::OutputBuffer buffer;
+                json::StreamBuilder response(buffer);
+                PrintRequest(requests[index].AsMap(), catalogue, router, response);
+                slot.body = buffer.Release();
+            }
+            catch (...)
+            {
+                slot.error = std::current_exception();
+            }
+
+            // Оповещаем под блокировкой: после последнего ответа ready_cv уничтожается
+            std::lock_guard lock(mutex);
+            slot.ready = true;
+            ++finished;
+            ready_cv.notify_all(); });
+    };
+
+    // Ждёт готовности условия, помогая пулу выполнять задачи
+    auto wait_for = [&](auto predicate)
+    {
+        std::unique_lock lock(mutex);
+        while (!predicate())
+        {
+            lock.unlock();
+            const bool ran = pool_->RunPendingTask();
+            lock.lock();
+            if (!ran && !predicate())
+            {
+                ready_cv.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+    };
+
+    for (size_t index = 0; index < requests.size(); ++index)
+    {
+        for (; submitted < requests.size() && submitted < index + window; ++submitted)
+        {
+            submit(submitted);
+        }
+
+        Slot &slot = slots[index % window];
+        wait_for([&slot]
+                 { return slot.ready; });
+
+        if (slot.error)
+        {
+            // Задачи ссылаются на локальные переменные, поэтому дожидаемся всех отправленных
+            wait_for([&]
+                     { return finished == submitted; });
+            std::rethrow_exception(slot.error);
+        }
+
+        if (slot.direct)
+        {
+            PrintRequest(requests[index].AsMap(), catalogue, router, builder);
+        }
+        else if (!slot.body.empty())
+        {
+            builder.RawValue(slot.body);
+        }
+        slot = Slot{};
+    }
+}
+
+void JsonReader::PrintRequest(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const
+{
+    if (!stats_)
+    {
+        PrintAnswer(request_map, catalogue, router, builder);
+        return;
+    }
+
+    const auto start = stats::Clock::now();
+    PrintAnswer(request_map, catalogue, router, builder);
+    stats_->AddRequest(request_map.at("type").AsStringView(), stats::ElapsedNs(start));
+}
+
+void JsonReader::PrintAnswer(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const
+{
+    const auto type = request_map.at("type").AsStringView();
+
+    // Ответы на Bus, Stop и Route зависят только от имён, поэтому берутся из кэша
+    if (cache_ && (type == "Stop" || type == "Bus" || type == "Route"))
+    {
+        PrintCached(request_map, catalogue, router, builder);
+        return;
+    }
+
+    PrintUncached(request_map, catalogue, router, builder);
+}
+
+void JsonReader::PrintUncached(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const
+{
+    const auto type = request_map.at("type").AsStringView();
+
+    if (type == "Stop")
+        PrintStop(request_map, catalogue, builder);
+
+    if (type == "Bus")
+        PrintBus(request_map, catalogue, builder);
+
+    if (type == "Map")
+        PrintMap(request_map, catalogue, builder);
+
+    if (type == "Route")
+        PrintRouting(request_map, router, builder);
+
+    if (type == "RouteMap")
+        PrintRouteMap(request_map, catalogue, router, builder);
+}
+
+void JsonReader::PrintCached(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const
+{
+    const auto type = request_map.at("type").AsStringView();
+    const int id = request_map.at("id").AsInt();
+
+    // Ключ: тип и имена, разделённые нулевым байтом, который не встречается в именах
+    std::string key(type);
+    if (type == "Route")
+    {
+        key.push_back('\0');
+        key.append(request_map.at("from").AsStringView());
+        key.push_back('\0');
+        key.append(request_map.at("to").AsStringView());
+    }
+    else
+    {
+        key.push_back('\0');
+        key.append(request_map.at("name").AsStringView());
+    }
+
+    auto response = cache_->Find(key);
+    if (!response)
+    {
+        io::OutputBuffer buffer;
+        json::StreamBuilder response_builder(buffer);
+        PrintUncached(request_map, catalogue, router, response_builder);
+
+        auto split = cache::CachedResponse::Split(buffer.View(), "request_id");
+        if (!split)
+        {
+            builder.RawValue(buffer.View());
+            return;
+        }
+        response = std::make_shared<const cache::CachedResponse>(std::move(*split));
+        cache_->Insert(std::move(key), response);
+    }
+
+    char id_str[16];
+    const auto [id_end, ec] = std::to_chars(id_str, id_str + sizeof(id_str), id);
+    builder.RawValue({response->head, std::string_view(id_str, id_end - id_str), response->tail});
+}
+
+// Ключи ответов выводятся в алфавитном порядке, как их упорядочивал json::Dict
+void JsonReader::PrintNotFound(int id, json::StreamBuilder &builder) const
+{
+    builder.StartDict()
+        .Key("error_message")
+        .Value("not found")
+        .Key("request_id")
+        .Value(id)
+        .EndDict();
+}
+
+void JsonReader::PrintBus(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, json::StreamBuilder &builder) const
+{
+    const std::string_view bus_name = request_map.at("name").AsStringView();
+    const int id = request_map.at("id").AsInt();
+
+    if (!catalogue.FindBus(bus_name))
+    {
+        PrintNotFound(id, builder);
+        return;
+    }
+
+    const auto &result_info = GetBusStat(bus_name, catalogue);
+    builder.StartDict()
+        .Key("curvature")
+        .Value(result_info->curvature)
+        .Key("request_id")
+        .Value(id)
+        .Key("route_length")
+        .Value(result_info->route_length)
+        .Key("stop_count")
+        .Value(static_cast<int>(result_info->stops_on_route))
+        .Key("unique_stop_count")
+        .Value(static_cast<int>(result_info->unique_stops))
+        .EndDict();
+}
+
+void JsonReader::PrintStop(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, json::StreamBuilder &builder) const
+{
+    const std::string_view stop_name = request_map.at("name").AsStringView();
+    const int id = request_map.at("id").AsInt();
+
+    if (!catalogue.FindStop(stop_name))
+    {
+        PrintNotFound(id, builder);
+        return;
+    }
+
+    builder.StartDict().Key("buses").StartArray();
+
+    for (auto &bus : GetBusesByStop(stop_name, catalogue))
+    {
+        builder.Value(bus);
+    }
+
+    builder.EndArray()
+        .Key("request_id")
+        .Value(id)
+        .EndDict();
+}
+
+void JsonReader::PrintMap(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, json::StreamBuilder &builder) const
+{
+    if (request_map.count("bbox") || request_map.count("tile"))
+    {
+        PrintMapViewport(request_map, catalogue, builder);
+        return;
+    }
+
+    const int id = request_map.at("id").AsInt();
+
+    if (stream_map_)
+    {
+        builder.StartDict()
+            .Key("map")
+            .StringValue([this, &catalogue](io::OutputBuffer &out)
+                         { GetMapRenderer().RenderMap(catalogue.GetSortedBuses(), out); })
+            .Key("request_id")
+            .Value(id)
+            .EndDict();
+        return;
+    }
+
+    builder.StartDict()
+        .Key("map")
+        .RawValue(GetRenderedMap(catalogue).json_string)
+        .Key("request_id")
+        .Value(id)
+        .EndDict();
+}
+
+// Часть карты: "bbox" с границами min_lat, min_lng, max_lat, max_lng или тайл "tile" с ключами z, x, y
+void JsonReader::PrintMapViewport(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, json::StreamBuilder &builder) const
+{
+    const int id = request_map.at("id").AsInt();
+    const renderer::MapIndex &index = GetMapIndex(catalogue);
+    const renderer::MapRenderer &map_renderer = GetMapRenderer();
+
+    renderer::Rect viewport;
+    if (const auto it = request_map.find("tile"); it != request_map.end())
+    {
+        const json::Dict &tile = it->second.AsMap();
+        viewport = map_renderer.GetTileRect(tile.at("z").AsInt(), tile.at("x").AsInt(), tile.at("y").AsInt());
+    }
+    else
+    {
+        const json::Dict &bbox = request_map.at("bbox").AsMap();
+        viewport = index.GetBoundingBoxRect({bbox.at("min_lat").AsDouble(), bbox.at("min_lng").AsDouble()},
+                                            {bbox.at("max_lat").AsDouble(), bbox.at("max_lng").AsDouble()});
+    }
+
+    builder.StartDict()
+        .Key("map")
+        .StringValue([&](io::OutputBuffer &out)
+                     { map_renderer.RenderViewport(index, viewport, out); })
+        .Key("request_id")
+        .Value(id)
+        .EndDict();
+}
+
+renderer::MapRenderer JsonReader::ParseRenderSettings(const json::Dict &request_map) const
+{
+    renderer::RenderSettings render_settings;
+    render_settings.width = request_map.at("width").AsDouble();
+    render_settings.height = request_map.at("height").AsDouble();
+    render_settings.padding = request_map.at("padding").AsDouble();
+    render_settings.stop_radius = request_map.at("stop_radius").AsDouble();
+    render_settings.line_width = request_map.at("line_width").AsDouble();
+    render_settings.bus_label_font_size = request_map.at("bus_label_font_size").AsInt();
+    const json::Array &bus_label_offset = request_map.at("bus_label_offset").AsArray();
+    render_settings.bus_label_offset = {bus_label_offset[0].AsDouble(), bus_label_offset[1].AsDouble()};
+    render_settings.stop_label_font_size = request_map.at("stop_label_font_size").AsInt();
+    const json::Array &stop_label_offset = request_map.at("stop_label_offset").AsArray();
+    render_settings.stop_label_offset = {stop_label_offset[0].AsDouble(), stop_label_offset[1].AsDouble()};
+    render_settings.underlayer_width = request_map.at("underlayer_width").AsDouble();
+
+    const auto &underlayer_color_json = request_map.at("underlayer_color");
+    if (underlayer_color_json.IsString())
+    {
+        render_settings.underlayer_color = std::string(underlayer_color_json.AsStringView());
+    }
+    else if (underlayer_color_json.IsArray())
+    {
+        const json::Array &underlayer_color = underlayer_color_json.AsArray();
+        if (underlayer_color.size() == 3)
+        {
+            render_settings.underlayer_color = svg::Rgb(static_cast<uint8_t>(underlayer_color[0].AsInt()), static_cast<uint8_t>(underlayer_color[1].AsInt()), static_cast<uint8_t>(underlayer_color[2].AsInt()));
+        }
+        else if (underlayer_color.size() == 4)
+        {
+            render_settings.underlayer_color = svg::Rgba(static_cast<uint8_t>(underlayer_color[0].AsInt()), static_cast<uint8_t>(underlayer_color[1].AsInt()), static_cast<uint8_t>(underlayer_color[2].AsInt()), underlayer_color[3].AsDouble());
+        }
+        else
+        {
+            throw std::logic_error("wrong underlayer colortype");
+        }
+    }
+    else
+    {
+        throw std::logic_error("wrong underlayer color");
+    }
+
+    const json::Array &color_palette = request_map.at("color_palette").AsArray();
+    for (const auto &color_element : color_palette)
+    {
+        if (color_element.IsString())
+        {
+            render_settings.color_palette.push_back(std::string(color_element.AsStringView()));
+        }
+        else if (color_element.IsArray())
+        {
+            const json::Array &color_type = color_element.AsArray();
+            if (color_type.size() == 3)
+            {
+                render_settings.color_palette.push_back(svg::Rgb(static_cast<uint8_t>(color_type[0].AsInt()), static_cast<uint8_t>(color_type[1].AsInt()), static_cast<uint8_t>(color_type[2].AsInt())));
+            }
+            else if (color_type.size() == 4)
+            {
+                render_settings.color_palette.push_back(svg::Rgba(static_cast<uint8_t>(color_type[0].AsInt()), static_cast<uint8_t>(color_type[1].AsInt()), static_cast<uint8_t>(color_type[2].AsInt()), color_type[3].AsDouble()));
+            }
+            else
+            {
+                throw std::logic_error("wrong color palette type");
+            }
+        }
+        else
+        {
+            throw std::logic_error("wrong color palette");
+        }
+    }
+
+    // Необязательные ключи: фиксированное число знаков после точки и отступ объектов SVG
+    if (const auto it = request_map.find("svg_precision"); it != request_map.end())
+    {
+        const int precision = it->second.AsInt();
+        if (precision < 0 || precision > 17)
+        {
+            throw std::logic_error("wrong svg precision");
+        }
+        render_settings.svg_options.precision = precision;
+    }
+    if (const auto it = request_map.find("svg_indent"); it != request_map.end())
+    {
+        const int indent = it->second.AsInt();
+        if (indent < 0)
+        {
+            throw std::logic_error("wrong svg indent");
+        }
+        render_settings.svg_options.indent = indent;
+    }
+    if (const auto it = request_map.find("svg_compact"); it != request_map.end())
+    {
+        render_settings.svg_compact = it->second.AsBool();
+    }
+    if (const auto it = request_map.find("lod_tolerance"); it != request_map.end())
+    {
+        const double tolerance = it->second.AsDouble();
+        if (tolerance < 0.0)
+        {
+            throw std::logic_error("wrong lod tolerance");
+        }
+        render_settings.lod_tolerance = tolerance;
+    }
+    return render_settings;
+}
+
+void JsonReader::PrintRouting(const json::Dict &request_map, const transport_catalogue::Router &router, json::StreamBuilder &builder) const
+{
+    const int id = request_map.at("id").AsInt();
+    const std::string_view stop_from = request_map.at("from").AsStringView();
+    const std::string_view stop_to = request_map.at("to").AsStringView();
+    const auto &graph_router_info = router.FindInfoRoute(stop_from, stop_to);
+
+    if (!graph_router_info.route_setting)
+    {
+        PrintNotFound(id, builder);
+        return;
+    }
+
+    double total_time = 0.0;
+    builder.StartDict().Key("items").StartArray();
+
+    for (auto &edge : graph_router_info.edges)
+    {
+        if (edge.quality == 0)
+        {
+            builder.StartDict()
+                .Key("stop_name")
+                .Value(edge.name)
+                .Key("time")
+                .Value(edge.weight)
+                .Key("type")
+                .Value("Wait")
+                .EndDict();
+        }
+        else
+        {
+            builder.StartDict()
+                .Key("bus")
+                .Value(edge.name)
+                .Key("span_count")
+                .Value(static_cast<int>(edge.quality))
+                .Key("time")
+                .Value(edge.weight)
+                .Key("type")
+                .Value("Bus")
+                .EndDict();
+        }
+
+        total_time += edge.weight;
+    }
+
+    builder.EndArray()
+        .Key("request_id")
+        .Value(id)
+        .Key("total_time")
+        .Value(total_time)
+        .EndDict();
+}
+
+// Карта с найденным маршрутом: готовая карта из кэша, к которой перед закрывающим тегом
+// дописывается слой маршрута. Базовая карта хранится уже в виде JSON-строки, поэтому
+// на запрос экранируется только слой маршрута
+void JsonReader::PrintRouteMap(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const
+{
+    using namespace std::literals;
+    static constexpr std::string_view ESCAPED_SVG_END = "</svg>\\n\""sv;
+
+    const int id = request_map.at("id").AsInt();
+    const auto &graph_router_info = router.FindInfoRoute(request_map.at("from").AsStringView(), request_map.at("to").AsStringView());
+    if (!graph_router_info.route_setting)
+    {
+        PrintNotFound(id, builder);
+        return;
+    }
+
+    std::vector<renderer::RouteSegment> segments;
+    for (const auto &edge : graph_router_info.edges)
+    {
+        // Рёбра ожидания на остановке на карте не рисуются
+        if (edge.quality == 0)
+            continue;
+        segments.push_back({edge.name, router.GetStopByVertex(edge.from), router.GetStopByVertex(edge.to), edge.quality});
+    }
+
+    const std::string_view base_map = GetRenderedMap(catalogue).json_string;
+    const renderer::MapRenderer &map_renderer = GetMapRenderer();
+    const svg::Document overlay_document = map_renderer.GetRouteOverlay(map_cache_, segments);
+    if (stats_)
+    {
+        stats_->UpdateMemoryPeak("route_overlay_svg", static_cast<long long>(overlay_document.GetMemoryUsage()));
+    }
+    io::OutputBuffer overlay;
+    overlay_document.RenderObjects(overlay, map_renderer.GetRenderOptions());
+
+    io::OutputBuffer escaped;
+    escaped.Reserve(overlay.Size() + overlay.Size() / 8 + 2);
+    json::PrintString(overlay.View(), escaped);
+    // Кавычки вокруг слоя не нужны: он вставляется внутрь строки карты
+    const std::string_view escaped_overlay = escaped.View().substr(1, escaped.Size() - 2);
+
+    builder.StartDict()
+        .Key("map")
+        .RawValue({base_map.substr(0, base_map.size() - ESCAPED_SVG_END.size()), escaped_overlay, ESCAPED_SVG_END})
+        .Key("request_id")
+        .Value(id)
+        .EndDict();
+}
+
+std::optional<transport_catalogue::InfoRoute> JsonReader::GetBusStat(const std::string_view &bus_name, const transport_catalogue::TransportCatalogue &catalogue) const
+{
+    return catalogue.InformationRoute(std::string(bus_name));
+}
+
+const std::set<std::string> &JsonReader::GetBusesByStop(const std::string_view &stop_name, const transport_catalogue::TransportCatalogue &catalogue) const
+{
+    return catalogue.FindStop(stop_name)->passing_buses;
+}
+
+svg::Document JsonReader::RenderMap(const transport_catalogue::TransportCatalogue &catalogue) const
+{
+    renderer::MapRenderer result(ParseRenderSettings(GetRenderSettings().AsMap()));
+    return result.GetDocumentSVG(catalogue.GetSortedBuses());
+}
+
+const JsonReader::RenderedMap &JsonReader::GetRenderedMap(const transport_catalogue::TransportCatalogue &catalogue) const
+{
+    // Внутри call_once пул не используется: ожидая частей ParallelFor, поток выполняет чужие задачи,
+    // и задача с запросом карты вошла бы в call_once того же флага повторно
+    std::call_once(map_once_, [this, &catalogue]
+                   {
+        rendered_map_ = BuildRenderedMap(catalogue, map_cache_, nullptr);
+        map_rendered_ = true; });
+
+    return rendered_map_;
+}
+
+JsonReader::RenderedMap JsonReader::BuildRenderedMap(const transport_catalogue::TransportCatalogue &catalogue, renderer::MapCache &cache, parallel::ThreadPool *pool) const
+{
+    const stats::PhaseTimer timer(stats_, "render_map");
+    GetMapRenderer().UpdateCache(catalogue.GetSortedBuses(), cache, pool);
+    if (stats_)
+    {
+        stats_->SetMemory("map_cache", static_cast<long long>(cache.GetMemoryUsage()));
+    }
+
+    // SVG экранируется кусками по мере вывода из кэша, без промежуточной копии всей карты
+    io::OutputBuffer escaped;
+    escaped.Put('"');
+    {
+        io::OutputBuffer svg_out([&escaped](std::string_view chunk)
+                                 { json::PrintStringContent(chunk, escaped); });
+        cache.Render(svg_out);
+        svg_out.Flush();
+    }
+    escaped.Put('"');
+
+    RenderedMap result;
+    result.json_string = escaped.Release();
+    if (stats_)
+    {
+        stats_->SetMemory("rendered_map", static_cast<long long>(result.json_string.capacity()));
+    }
+    return result;
+}
+
+const renderer::MapRenderer &JsonReader::GetMapRenderer() const
+{
+    std::call_once(map_renderer_once_, [this]
+                   { map_renderer_.emplace(ParseRenderSettings(GetRenderSettings().AsMap())); });
+    return *map_renderer_;
+}
+
+const renderer::MapIndex &JsonReader::GetMapIndex(const transport_catalogue::TransportCatalogue &catalogue) const
+{
+    std::call_once(map_index_once_, [this, &catalogue]
+                   {
+        const stats::PhaseTimer timer(stats_, "build_map_index");
+        map_index_.emplace(catalogue.GetSortedBuses(), GetMapRenderer().GetSettings());
+        if (stats_)
+        {
+            stats_->SetMemory("map_index", static_cast<long long>(map_index_->GetMemoryUsage()));
+        } });
+
+    return *map_index_;
+}
+
+void JsonReader::PrerenderMap(const transport_catalogue::TransportCatalogue &catalogue) const
+{
+    if (map_rendered_)
+    {
+        return;
+    }
+
+    // Отрисовка с пулом идёт вне call_once; если карту тем временем отрисовал другой поток,
+    // устанавливается его результат, а этот отбрасывается
+    renderer::MapCache cache;
+    RenderedMap rendered = BuildRenderedMap(catalogue, cache, pool_);
+    std::call_once(map_once_, [&]
+                   {
+        map_cache_ = std::move(cache);
+        rendered_map_ = std::move(rendered);
+        map_rendered_ = true; });
+}
+
+transport_catalogue::RouteSettings JsonReader::FillRoutingSettings(const json::Node &settings) const
+{
+    transport_catalogue::RouteSettings routing_settings{settings.AsMap().at("bus_wait_time").AsInt(), settings.AsMap().at("bus_velocity").AsDouble()};
+    return routing_settings;
 }
\ No newline at end of file
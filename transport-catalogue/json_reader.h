@@ -1,47 +1,131 @@
-#pragma once
-
-#include "transport_catalogue.h"
-#include "json.h"
-#include "map_renderer.h"
-#include "json_builder.h"
-#include "transport_router.h"
-
-#include <string>
-#include <string_view>
-#include <vector>
-#include <sstream>
-
-class JsonReader
-{
-public:
-    JsonReader(std::istream &input) : doc_(json::Load(input)) {}
-
-    const json::Node &GetBaseRequests() const;
-    const json::Node &GetStatRequests() const;
-    const json::Node &GetRenderSettings() const;
-    const json::Node &GetRoutingSettings() const;
-
-    void AddCatalogue(transport_catalogue::TransportCatalogue &catalogue);
-
-    void PrintFunction(const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router) const;
-
-    svg::Document RenderMap(const transport_catalogue::TransportCatalogue &catalogue) const;
-
-    transport_catalogue::RouteSettings FillRoutingSettings(const json::Node &settings) const;
-
-private:
-    json::Document doc_;
-    json::Node ntr_ = nullptr;
-
-    transport_catalogue::ParseStops ParseStopWithDistances(const json::Dict &request_map) const;
-    transport_catalogue::ParseBus ParseBus(const json::Dict &request_map, transport_catalogue::TransportCatalogue &catalogue) const;
-    renderer::MapRenderer ParseRenderSettings(const json::Dict &request_map) const;
-
-    const json::Node PrintBus(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue) const;
-    const json::Node PrintStop(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue) const;
-    const json::Node PrintMap(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue) const;
-    const json::Node PrintRouting(const json::Dict &request_map, const transport_catalogue::Router &router) const;
-
-    std::optional<transport_catalogue::InfoRoute> GetBusStat(const std::string_view &bus_name, const transport_catalogue::TransportCatalogue &catalogue) const;
-    const std::set<std::string> GetBusesByStop(const std::string_view &stop_name, const transport_catalogue::TransportCatalogue &catalogue) const;
+#pragma once
+
+#include "transport_catalogue.h"
+#include "json.h"
+#include "map_renderer.h"
+#include "json_builder.h"
+#include "json_stream_builder.h"
+#include "transport_router.h"
+#include "thread_pool.h"
+#include "response_cache.h"
+#include "run_stats.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sstream>
+
+class JsonReader
+{
+public:
+    JsonReader(std::istream &input) : doc_(json::LoadView(input)) {}
+    explicit JsonReader(json::Document doc) : doc_(std::move(doc)) {}
+
+    const json::Node &GetBaseRequests() const;
+    const json::Node &GetStatRequests() const;
+    const json::Node &GetRenderSettings() const;
+    const json::Node &GetRoutingSettings() const;
+
+    // Оценка памяти входного документа
+    size_t GetDocumentMemoryUsage() const;
+
+    // Есть ли среди stat_requests запрос указанного типа
+    bool HasStatRequest(std::string_view type) const;
+
+    // Пул потоков для параллельной обработки; без пула запросы обрабатываются последовательно
+    void SetThreadPool(parallel::ThreadPool *pool);
+
+    // Кэш сериализованных ответов на повторяющиеся запросы; без кэша ответы всегда вычисляются заново
+    void SetResponseCache(cache::ResponseCache *cache);
+
+    // Отчёт, в который записываются время отрисовки карты и статистика запросов по типам
+    void SetRunStats(stats::RunStats *stats);
+
+    // Потоковый вывод карты: каждый запрос полной карты отрисовывается заново прямо в ответ,
+    // SVG экранируется на лету, и ни карта, ни её объекты целиком в памяти не хранятся.
+    // По умолчанию карта отрисовывается один раз и хранится готовой JSON-строкой
+    void SetMapStreaming(bool enabled);
+
+    void AddCatalogue(transport_catalogue::TransportCatalogue &catalogue);
+
+    void PrintFunction(const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, io::OutputBuffer &output) const;
+
+    // Выводит ответ на один запрос в компактном виде (используется в режиме сервера)
+    void PrintResponse(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, io::OutputBuffer &output) const;
+
+    svg::Document RenderMap(const transport_catalogue::TransportCatalogue &catalogue) const;
+
+    // Карта, отрисованная один раз, в виде JSON-строки с кавычками.
+    // Каталог не меняется после загрузки, поэтому все запросы Map получают одну и ту же карту
+    struct RenderedMap
+    {
+        std::string json_string;
+    };
+
+    const RenderedMap &GetRenderedMap(const transport_catalogue::TransportCatalogue &catalogue) const;
+
+    // Отрисовщик карты с настройками из render_settings; создаётся один раз
+    const renderer::MapRenderer &GetMapRenderer() const;
+
+    // Маршруты и остановки, спроецированные и разложенные по сетке для запросов части карты
+    // (Map с ключом bbox или tile); строятся один раз при первом таком запросе
+    const renderer::MapIndex &GetMapIndex(const transport_catalogue::TransportCatalogue &catalogue) const;
+
+    // Отрисовывает карту заранее, чтобы первый запрос Map не ждал отрисовки. Только здесь отрисовка
+    // делится между потоками пула, поэтому вызывать нужно до раздачи запросов по задачам пула
+    void PrerenderMap(const transport_catalogue::TransportCatalogue &catalogue) const;
+
+    transport_catalogue::RouteSettings FillRoutingSettings(const json::Node &settings) const;
+
+private:
+    json::Document doc_;
+    json::Node ntr_ = nullptr;
+    parallel::ThreadPool *pool_ = nullptr;
+    cache::ResponseCache *cache_ = nullptr;
+    stats::RunStats *stats_ = nullptr;
+    bool stream_map_ = false;
+    mutable std::once_flag map_once_;
+    mutable std::atomic<bool> map_rendered_{false};
+    mutable RenderedMap rendered_map_;
+    mutable renderer::MapCache map_cache_;
+    mutable std::once_flag map_renderer_once_;
+    mutable std::optional<renderer::MapRenderer> map_renderer_;
+    mutable std::once_flag map_index_once_;
+    mutable std::optional<renderer::MapIndex> map_index_;
+
+    // Вызывает body(begin, end) для частей диапазона [0, count): в пуле потоков, если он задан
+    void ForEachChunk(size_t count, const std::function<void(size_t, size_t)> &body) const;
+
+    transport_catalogue::ParseStops ParseStopWithDistances(const json::Dict &request_map) const;
+    transport_catalogue::ParseBus ParseBus(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue) const;
+    renderer::MapRenderer ParseRenderSettings(const json::Dict &request_map) const;
+
+    // Запрос полной карты, который при потоковом выводе пишется прямо в ответ
+    bool IsStreamedMap(const json::Dict &request_map) const;
+
+    // Запрос, в ответ на который выводится карта, отрисованная один раз (GetRenderedMap)
+    bool UsesRenderedMap(const json::Dict &request_map) const;
+
+    // Заполняет cache и возвращает карту JSON-строкой; с пулом фрагменты отрисовываются параллельно
+    RenderedMap BuildRenderedMap(const transport_catalogue::TransportCatalogue &catalogue, renderer::MapCache &cache, parallel::ThreadPool *pool) const;
+
+    void PrintParallel(const json::Array &requests, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const;
+    void PrintRequest(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const;
+    void PrintAnswer(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const;
+    void PrintUncached(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const;
+    void PrintCached(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const;
+    void PrintNotFound(int id, json::StreamBuilder &builder) const;
+    void PrintBus(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, json::StreamBuilder &builder) const;
+    void PrintStop(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, json::StreamBuilder &builder) const;
+    void PrintMap(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, json::StreamBuilder &builder) const;
+    void PrintMapViewport(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, json::StreamBuilder &builder) const;
+    void PrintRouting(const json::Dict &request_map, const transport_catalogue::Router &router, json::StreamBuilder &builder) const;
+    void PrintRouteMap(const json::Dict &request_map, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router, json::StreamBuilder &builder) const;
+
+    std::optional<transport_catalogue::InfoRoute> GetBusStat(const std::string_view &bus_name, const transport_catalogue::TransportCatalogue &catalogue) const;
+    const std::set<std::string> &GetBusesByStop(const std::string_view &stop_name, const transport_catalogue::TransportCatalogue &catalogue) const;
 };
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "json_stream_builder.h"
+
+namespace json
+{
+    using namespace std::literals;
+
+    void StreamBuilder::ValueRef::Print(io::OutputBuffer &output) const
+    {
+        switch (type_)
+        {
+        case Type::NUL:
+            output.Write("null"sv);
+            break;
+        case Type::BOOL:
+            output.Write(bool_ ? "true"sv : "false"sv);
+            break;
+        case Type::INT:
+            output.WriteInt(int_);
+            break;
+        case Type::DOUBLE:
+            output.WriteDouble(double_);
+            break;
+        case Type::STRING:
+            PrintString(string_, output);
+            break;
+        case Type::NODE:
+            PrintNode(*node_, output);
+            break;
+        }
+    }
+
+    StreamBuilder::DictValueContext StreamBuilder::Key(std::string_view key)
+    {
+        if (depth_ == 0 || !stack_[depth_ - 1].is_dict || key_pending_)
+            throw std::logic_error("Error calling Key()");
+
+        Frame &frame = stack_[depth_ - 1];
+        if (frame.has_items)
+        {
+            output_.Put(',');
+        }
+        frame.has_items = true;
+
+        PrintString(key, output_);
+        output_.Put(':');
+        key_pending_ = true;
+
+        return BaseContext{*this};
+    }
+
+    StreamBuilder::BaseContext StreamBuilder::Value(ValueRef value)
+    {
+        BeforeValue();
+        value.Print(output_);
+        AfterValue();
+        return *this;
+    }
+
+    StreamBuilder::BaseContext StreamBuilder::RawValue(std::string_view serialized)
+    {
+        BeforeValue();
+        output_.Write(serialized);
+        AfterValue();
+        return *this;
+    }
+
+    StreamBuilder::BaseContext StreamBuilder::RawValue(std::initializer_list<std::string_view> parts)
+    {
+        BeforeValue();
+        for (const std::string_view part : parts)
+        {
+            output_.Write(part);
+        }
+        AfterValue();
+        return *this;
+    }
+
+    StreamBuilder::BaseContext StreamBuilder::StringValue(const std::function<void(io::OutputBuffer &)> &writer)
+    {
+        BeforeValue();
+        output_.Put('"');
+        {
+            // Записанное writer экранируется кусками по мере заполнения промежуточного буфера
+            io::OutputBuffer escaping([this](std::string_view chunk)
+                                      { PrintStringContent(chunk, output_); });
+            writer(escaping);
+            escaping.Flush();
+        }
+        output_.Put('"');
+        AfterValue();
+        return *this;
+    }
+
+    StreamBuilder::DictItemContext StreamBuilder::StartDict()
+    {
+        BeforeValue();
+        output_.Put('{');
+        Push(true);
+        return BaseContext{*this};
+    }
+
+    StreamBuilder::ArrayItemContext StreamBuilder::StartArray()
+    {
+        BeforeValue();
+        output_.Put('[');
+        Push(false);
+        return BaseContext{*this};
+    }
+
+    StreamBuilder &StreamBuilder::EndDict()
+    {
+        if (depth_ == 0 || !stack_[depth_ - 1].is_dict || key_pending_)
+        {
+            throw std::logic_error("Error calling EndDict()");
+        }
+        output_.Put('}');
+        --depth_;
+        AfterValue();
+        return *this;
+    }
+
+    StreamBuilder &StreamBuilder::EndArray()
+    {
+        if (depth_ == 0 || stack_[depth_ - 1].is_dict)
+        {
+            throw std::logic_error("Error calling EndArray()");
+        }
+        output_.Put(']');
+        --depth_;
+        AfterValue();
+        return *this;
+    }
+
+    void StreamBuilder::Finish()
+    {
+        if (!root_done_ || depth_ > 0)
+        {
+            throw std::logic_error("Error calling Finish()");
+        }
+    }
+
+    void StreamBuilder::BeforeValue()
+    {
+        if (depth_ == 0)
+        {
+            if (root_done_)
+                throw std::logic_error("Attempt to change finalized JSON");
+            return;
+        }
+
+        Frame &frame = stack_[depth_ - 1];
+        if (frame.is_dict)
+        {
+            if (!key_pending_)
+                throw std::logic_error("Error: the key is missing");
+            key_pending_ = false;
+            return;
+        }
+
+        if (frame.has_items)
+        {
+            output_.Put(',');
+        }
+        frame.has_items = true;
+    }
+
+    void StreamBuilder::AfterValue()
+    {
+        if (depth_ == 0)
+        {
+            root_done_ = true;
+        }
+    }
+
+    void StreamBuilder::Push(bool is_dict)
+    {
+        if (depth_ == MAX_DEPTH)
+        {
+            throw std::logic_error("Error: JSON nesting is too deep");
+        }
+        stack_[depth_++] = Frame{is_dict, false};
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "json.h"
+#include "output_buffer.h"
+
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace json
+{
+    /*
+     * Потоковый аналог json::Builder: тот же fluent-интерфейс с проверкой контекста,
+     * но значения сразу сериализуются в буфер вывода в компактном виде, без построения
+     * промежуточных узлов. Ключи словаря выводятся в порядке вызова Key()
+     */
+    class StreamBuilder
+    {
+    private:
+        class BaseContext;
+        class DictItemContext;
+        class DictValueContext;
+        class ArrayItemContext;
+
+    public:
+        // Значение для вывода без копирования: скаляр, строка или готовый узел
+        class ValueRef
+        {
+        public:
+            ValueRef(std::nullptr_t) : type_(Type::NUL) {}
+            ValueRef(bool value) : type_(Type::BOOL), bool_(value) {}
+            ValueRef(int value) : type_(Type::INT), int_(value) {}
+            ValueRef(long long value) : type_(Type::INT), int_(value) {}
+            ValueRef(double value) : type_(Type::DOUBLE), double_(value) {}
+            ValueRef(const char *value) : type_(Type::STRING), string_(value) {}
+            ValueRef(std::string_view value) : type_(Type::STRING), string_(value) {}
+            ValueRef(const std::string &value) : type_(Type::STRING), string_(value) {}
+            ValueRef(const Node &value) : type_(Type::NODE), node_(&value) {}
+
+            void Print(io::OutputBuffer &output) const;
+
+        private:
+            enum class Type
+            {
+                NUL,
+                BOOL,
+                INT,
+                DOUBLE,
+                STRING,
+                NODE,
+            };
+
+            Type type_;
+            bool bool_ = false;
+            long long int_ = 0;
+            double double_ = 0.0;
+            std::string_view string_;
+            const Node *node_ = nullptr;
+        };
+
+        explicit StreamBuilder(io::OutputBuffer &output) : output_(output) {}
+
+        DictValueContext Key(std::string_view key);
+        BaseContext Value(ValueRef value);
+        // Вставляет уже сериализованное значение (например, ответ из кэша)
+        BaseContext RawValue(std::string_view serialized);
+        // Вставляет значение, сериализованное по частям (например, ответ из кэша с подставленным id)
+        BaseContext RawValue(std::initializer_list<std::string_view> parts);
+        // Выводит строку, текст которой writer пишет в переданный буфер: текст экранируется
+        // по мере записи и целиком в памяти не собирается (например, большая карта SVG)
+        BaseContext StringValue(const std::function<void(io::OutputBuffer &)> &writer);
+        DictItemContext StartDict();
+        ArrayItemContext StartArray();
+        StreamBuilder &EndDict();
+        StreamBuilder &EndArray();
+        // Проверяет, что корневое значение выведено полностью
+        void Finish();
+
+    private:
+        static constexpr size_t MAX_DEPTH = 64;
+
+        struct Frame
+        {
+            bool is_dict = false;
+            bool has_items = false;
+        };
+
+        io::OutputBuffer &output_;
+        std::array<Frame, MAX_DEPTH> stack_{};
+        size_t depth_ = 0;
+        bool key_pending_ = false;
+        bool root_done_ = false;
+
+        void BeforeValue();
+        void AfterValue();
+        void Push(bool is_dict);
+
+        class BaseContext
+        {
+        public:
+            BaseContext(StreamBuilder &builder) : builder_(builder) {}
+            void Finish() { builder_.Finish(); }
+            DictValueContext Key(std::string_view key) { return builder_.Key(key); }
+            BaseContext Value(ValueRef value) { return builder_.Value(value); }
+            BaseContext RawValue(std::string_view serialized) { return builder_.RawValue(serialized); }
+            BaseContext RawValue(std::initializer_list<std::string_view> parts) { return builder_.RawValue(parts); }
+            BaseContext StringValue(const std::function<void(io::OutputBuffer &)> &writer) { return builder_.StringValue(writer); }
+            DictItemContext StartDict() { return builder_.StartDict(); }
+            ArrayItemContext StartArray() { return builder_.StartArray(); }
+            BaseContext EndDict() { return builder_.EndDict(); }
+            BaseContext EndArray() { return builder_.EndArray(); }
+
+        private:
+            StreamBuilder &builder_;
+        };
+
+        class DictItemContext : public BaseContext
+        {
+        public:
+            DictItemContext(BaseContext base) : BaseContext(base) {}
+            void Finish() = delete;
+            BaseContext Value(ValueRef value) = delete;
+            BaseContext RawValue(std::string_view serialized) = delete;
+            BaseContext RawValue(std::initializer_list<std::string_view> parts) = delete;
+            BaseContext StringValue(const std::function<void(io::OutputBuffer &)> &writer) = delete;
+            BaseContext EndArray() = delete;
+            DictItemContext StartDict() = delete;
+            ArrayItemContext StartArray() = delete;
+        };
+
+        class ArrayItemContext : public BaseContext
+        {
+        public:
+            ArrayItemContext(BaseContext base) : BaseContext(base) {}
+            ArrayItemContext Value(ValueRef value) { return BaseContext::Value(value); }
+            ArrayItemContext RawValue(std::string_view serialized) { return BaseContext::RawValue(serialized); }
+            ArrayItemContext RawValue(std::initializer_list<std::string_view> parts) { return BaseContext::RawValue(parts); }
+            ArrayItemContext StringValue(const std::function<void(io::OutputBuffer &)> &writer) { return BaseContext::StringValue(writer); }
+            void Finish() = delete;
+            DictValueContext Key(std::string_view key) = delete;
+            BaseContext EndDict() = delete;
+        };
+
+        class DictValueContext : public BaseContext
+        {
+        public:
+            DictValueContext(BaseContext base) : BaseContext(base) {}
+            DictItemContext Value(ValueRef value) { return BaseContext::Value(value); }
+            DictItemContext RawValue(std::string_view serialized) { return BaseContext::RawValue(serialized); }
+            DictItemContext RawValue(std::initializer_list<std::string_view> parts) { return BaseContext::RawValue(parts); }
+            DictItemContext StringValue(const std::function<void(io::OutputBuffer &)> &writer) { return BaseContext::StringValue(writer); }
+            void Finish() = delete;
+            DictValueContext Key(std::string_view key) = delete;
+            BaseContext EndDict() = delete;
+            BaseContext EndArray() = delete;
+        };
+    };
+}
@@ -1,20 +1,221 @@
-#include "json_reader.h"
-#include "map_renderer.h"
-
-int main()
-{
-#ifdef _WIN64
-    freopen("input.json", "r", stdin);
-    freopen("output.json", "w", stdout);
-   
-#endif
-
-    transport_catalogue::TransportCatalogue catalogue;
-    JsonReader requests(std::cin);
-    requests.AddCatalogue(catalogue);
-
-    const auto &routing_settings = requests.FillRoutingSettings(requests.GetRoutingSettings());
-    const transport_catalogue::Router router = {routing_settings, catalogue};
-
-    requests.PrintFunction(catalogue, router);
-}
+#include "json_reader.h"
+#include "memory_usage.h"
+#include "map_renderer.h"
+#include "thread_pool.h"
+#include "request_server.h"
+#include "run_stats.h"
+
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+int main(int argc, char *argv[])
+{
+#ifdef _WIN64
+    freopen("input.json", "r", stdin);
+    freopen("output.json", "w", stdout);
+   
+#endif
+
+    // --threads N задаёт число потоков обработки запросов (по умолчанию — число ядер),
+    // --cache N — ёмкость кэша ответов (0 отключает кэш),
+    // --cache-stats выводит счётчики попаданий кэша в stderr,
+    // --input FILE читает исходный документ из файла вместо stdin,
+    // --prerender-map отрисовывает карту сразу после загрузки каталога,
+    // --stream-map выводит каждую полную карту прямо в ответ, не храня её в памяти,
+    // --serve запускает режим сервиса: после построения каталога запросы читаются построчно
+    // из stdin (или из Unix domain socket, заданного --socket PATH),
+    // --stats выводит в stderr отчёт о времени этапов и запросов и о памяти подсистем (--stats-file FILE — в файл)
+    size_t thread_count = std::thread::hardware_concurrency();
+    size_t cache_capacity = 65536;
+    bool print_cache_stats = false;
+    std::string input_path;
+    bool prerender_map = false;
+    bool stream_map = false;
+    bool serve = false;
+    std::string socket_path;
+    bool print_stats = false;
+    std::string stats_path;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            thread_count = std::stoul(argv[++i]);
+        }
+        else if (arg == "--cache" && i + 1 < argc)
+        {
+            cache_capacity = std::stoul(argv[++i]);
+        }
+        else if (arg == "--cache-stats")
+        {
+            print_cache_stats = true;
+        }
+        else if (arg == "--input" && i + 1 < argc)
+        {
+            input_path = argv[++i];
+        }
+        else if (arg == "--prerender-map")
+        {
+            prerender_map = true;
+        }
+        else if (arg == "--stream-map")
+        {
+            stream_map = true;
+        }
+        else if (arg == "--serve")
+        {
+            serve = true;
+        }
+        else if (arg == "--socket" && i + 1 < argc)
+        {
+            serve = true;
+            socket_path = argv[++i];
+        }
+        else if (arg == "--stats")
+        {
+            print_stats = true;
+        }
+        else if (arg == "--stats-file" && i + 1 < argc)
+        {
+            print_stats = true;
+            stats_path = argv[++i];
+        }
+    }
+
+    std::unique_ptr<parallel::ThreadPool> pool;
+    if (thread_count > 1)
+    {
+        pool = std::make_unique<parallel::ThreadPool>(thread_count);
+    }
+
+    std::unique_ptr<cache::ResponseCache> response_cache;
+    if (cache_capacity > 0)
+    {
+        response_cache = std::make_unique<cache::ResponseCache>(cache_capacity);
+    }
+
+    std::unique_ptr<stats::RunStats> run_stats;
+    if (print_stats)
+    {
+        run_stats = std::make_unique<stats::RunStats>();
+    }
+
+    transport_catalogue::TransportCatalogue catalogue;
+    // В режиме сервиса со stdin из потока читается только исходный документ,
+    // строки запросов после него остаются в потоке
+    std::ifstream input_file;
+    if (!input_path.empty())
+    {
+        input_file.open(input_path, std::ios::binary);
+        if (!input_file)
+        {
+            std::cerr << "cannot open " << input_path << std::endl;
+            return 1;
+        }
+    }
+    std::istream &input = input_path.empty() ? std::cin : input_file;
+    const auto parse_start = run_stats ? stats::Clock::now() : stats::Clock::time_point{};
+    JsonReader requests = serve && input_path.empty() && socket_path.empty() ? JsonReader(json::LoadViewNext(input)) : JsonReader(input);
+    if (run_stats)
+    {
+        run_stats->AddPhase("parse_json", stats::ElapsedNs(parse_start));
+        run_stats->SetMemory("json_document", static_cast<long long>(requests.GetDocumentMemoryUsage()));
+    }
+    requests.SetThreadPool(pool.get());
+    requests.SetResponseCache(response_cache.get());
+    requests.SetRunStats(run_stats.get());
+    requests.SetMapStreaming(stream_map);
+    {
+        const stats::PhaseTimer timer(run_stats.get(), "add_catalogue");
+        requests.AddCatalogue(catalogue);
+    }
+
+    if (prerender_map)
+    {
+        requests.PrerenderMap(catalogue);
+    }
+
+    const auto &routing_settings = requests.FillRoutingSettings(requests.GetRoutingSettings());
+    const transport_catalogue::Router router = {routing_settings, catalogue, run_stats.get()};
+
+    // Маршрутизатор строится лениво, при первом запросе Route или RouteMap. Если такие запросы ожидаются,
+    // построение запускается в фоне, пока отвечаем на запросы Bus, Stop и Map.
+    // Деструктор future от std::async дожидается построения, в том числе при исключении
+    std::future<void> router_builder;
+    if (serve || requests.HasStatRequest("Route") || requests.HasStatRequest("RouteMap"))
+    {
+        router_builder = std::async(std::launch::async, [&router]
+                                    { router.Build(); });
+    }
+
+    io::OutputBuffer output(io::STDOUT_FD);
+
+    try
+    {
+        if (serve)
+        {
+            const server::RequestServer request_server(requests, catalogue, router);
+            if (!socket_path.empty())
+            {
+                request_server.ServeUnixSocket(socket_path);
+            }
+            else
+            {
+                request_server.ServeStream(std::cin, output);
+            }
+        }
+        else
+        {
+            const stats::PhaseTimer timer(run_stats.get(), "stat_requests");
+            requests.PrintFunction(catalogue, router, output);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        // Фоновое построение маршрутизатора дожидается деструктор router_builder
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (router_builder.valid())
+    {
+        router_builder.get();
+    }
+
+    if (print_cache_stats && response_cache)
+    {
+        const auto stats = response_cache->GetStats();
+        std::cerr << "{\"cache\":{\"hits\":" << stats.hits << ",\"misses\":" << stats.misses
+                  << ",\"evictions\":" << stats.evictions << "}}" << std::endl;
+    }
+
+    if (run_stats)
+    {
+        if (response_cache)
+        {
+            const auto cache_stats = response_cache->GetStats();
+            run_stats->SetCounter("cache_hits", static_cast<long long>(cache_stats.hits));
+            run_stats->SetCounter("cache_misses", static_cast<long long>(cache_stats.misses));
+            run_stats->SetCounter("cache_evictions", static_cast<long long>(cache_stats.evictions));
+        }
+
+        run_stats->SetMemory("catalogue", static_cast<long long>(catalogue.GetMemoryUsage()));
+        run_stats->SetMemory("graph", static_cast<long long>(router.GetGraph().GetMemoryUsage()));
+        run_stats->SetMemory("router", static_cast<long long>(router.GetMemoryUsage()));
+        run_stats->SetMemory("current_rss", static_cast<long long>(memory::CurrentRssBytes()));
+        run_stats->SetMemory("peak_rss", static_cast<long long>(memory::PeakRssBytes()));
+
+        std::ofstream stats_file;
+        if (!stats_path.empty())
+        {
+            stats_file.open(stats_path);
+        }
+        io::OutputBuffer stats_output(stats_path.empty() ? std::cerr : stats_file);
+        run_stats->Print(stats_output);
+        stats_output.Put('\n');
+    }
+}
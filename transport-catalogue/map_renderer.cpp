@@ -1,189 +1,1289 @@
 #include "map_renderer.h"
 
+#include "memory_usage.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace renderer
 {
-    std::vector<svg::Polyline> MapRenderer::GetRouteLines(const std::map<std::string_view, const transport_catalogue ::Bus *> &buses, const SphereProjector &sphere_projector) const
+    // Остановки маршрутов без повторов, по возрастанию имён, и их координаты в том же порядке
+    struct RouteStops
+    {
+        std::map<std::string_view, const transport_catalogue::Stop *> stops;
+        CoordinateBuffer coordinates;
+    };
+
+    namespace
+    {
+        RouteStops CollectStops(const std::map<std::string_view, const transport_catalogue::Bus *> &buses)
+        {
+            RouteStops result;
+            for (const auto &[bus_name, bus] : buses)
+            {
+                for (const auto &stop : bus->stops_for_bus)
+                {
+                    result.stops.emplace(stop->name_stop, stop);
+                }
+            }
+            result.coordinates.Reserve(result.stops.size());
+            for (const auto &[stop_name, stop] : result.stops)
+            {
+                result.coordinates.Add(stop->coordinates);
+            }
+            return result;
+        }
+
+        // Проекция строится по всем остановкам непустых маршрутов, как для полной карты:
+        // повторные вхождения остановки в маршруты не меняют границ
+        SphereProjector MakeProjector(const CoordinateBuffer &coordinates, const RenderSettings &settings)
+        {
+            return SphereProjector(coordinates, settings.width, settings.height, settings.padding);
+        }
+
+        // Ломаная маршрута; некольцевой маршрут проходится в обратную сторону без повтора конечной
+        std::vector<svg::Point> ProjectRoute(const transport_catalogue::Bus &bus, const SphereProjector &projector)
+        {
+            const auto &stops = bus.stops_for_bus;
+            std::vector<svg::Point> points;
+            points.reserve(bus.is_roundtrip ? stops.size() : stops.size() * 2 - 1);
+            for (const auto &stop : stops)
+            {
+                points.push_back(projector(stop->coordinates));
+            }
+            if (!bus.is_roundtrip)
+            {
+                for (auto it = std::next(stops.rbegin()); it != stops.rend(); ++it)
+                {
+                    points.push_back(projector((*it)->coordinates));
+                }
+            }
+            return points;
+        }
+
+        // Расстояние от точки p до отрезка [a, b]
+        double DistanceToSegment(svg::Point p, svg::Point a, svg::Point b)
+        {
+            const double dx = b.x - a.x;
+            const double dy = b.y - a.y;
+            const double length_squared = dx * dx + dy * dy;
+            double t = 0.0;
+            if (length_squared > 0.0)
+            {
+                t = std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / length_squared, 0.0, 1.0);
+            }
+            return std::hypot(p.x - (a.x + t * dx), p.y - (a.y + t * dy));
+        }
+
+        // Число символов UTF-8 строки
+        size_t CountCharacters(std::string_view text)
+        {
+            return static_cast<size_t>(std::count_if(text.begin(), text.end(), [](char c)
+                                                     { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; }));
+        }
+
+        // Подписи мельче пикселя в режиме упрощения не выводятся
+        constexpr int MIN_LABEL_FONT_SIZE = 1;
+        constexpr double LABEL_CHAR_WIDTH = 0.6;
+
+        // Отсекает отрезок [a, b] прямоугольником (алгоритм Лианга — Барски).
+        // Возвращает значения параметра t в точках входа и выхода или nullopt, если отрезок снаружи
+        std::optional<std::pair<double, double>> ClipSegment(svg::Point a, svg::Point b, const Rect &rect)
+        {
+            const double dx = b.x - a.x;
+            const double dy = b.y - a.y;
+            const double p[4] = {-dx, dx, -dy, dy};
+            const double q[4] = {a.x - rect.min.x, rect.max.x - a.x, a.y - rect.min.y, rect.max.y - a.y};
+
+            double t_enter = 0.0;
+            double t_exit = 1.0;
+            for (int i = 0; i < 4; ++i)
+            {
+                if (p[i] == 0.0)
+                {
+                    if (q[i] < 0.0)
+                    {
+                        return std::nullopt;
+                    }
+                    continue;
+                }
+                const double t = q[i] / p[i];
+                if (p[i] < 0.0)
+                {
+                    if (t > t_exit)
+                    {
+                        return std::nullopt;
+                    }
+                    t_enter = std::max(t_enter, t);
+                }
+                else
+                {
+                    if (t < t_enter)
+                    {
+                        return std::nullopt;
+                    }
+                    t_exit = std::min(t_exit, t);
+                }
+            }
+            return std::make_pair(t_enter, t_exit);
+        }
+
+        svg::Point Interpolate(svg::Point a, svg::Point b, double t)
+        {
+            if (t <= 0.0)
+            {
+                return a;
+            }
+            if (t >= 1.0)
+            {
+                return b;
+            }
+            return {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t};
+        }
+
+        // Обрезает ломаную прямоугольником; каждый видимый кусок становится отдельной ломаной
+        std::vector<std::vector<svg::Point>> ClipPolyline(const std::vector<svg::Point> &points, const Rect &rect)
+        {
+            std::vector<std::vector<svg::Point>> pieces;
+            if (points.size() == 1)
+            {
+                if (rect.Contains(points[0]))
+                {
+                    pieces.push_back(points);
+                }
+                return pieces;
+            }
+
+            // Предыдущий отрезок закончился внутри, и текущий продолжает тот же кусок
+            bool inside = false;
+            for (size_t i = 1; i < points.size(); ++i)
+            {
+                const auto clipped = ClipSegment(points[i - 1], points[i], rect);
+                if (!clipped)
+                {
+                    inside = false;
+                    continue;
+                }
+                const auto [t_enter, t_exit] = *clipped;
+                if (!inside)
+                {
+                    pieces.emplace_back();
+                    pieces.back().push_back(Interpolate(points[i - 1], points[i], t_enter));
+                }
+                pieces.back().push_back(Interpolate(points[i - 1], points[i], t_exit));
+                inside = t_exit >= 1.0;
+            }
+            return pieces;
+        }
+
+        // Строки объектов документа без заголовка и закрывающего тега
+        std::string RenderFragment(const svg::Document &document, const svg::RenderOptions &options)
+        {
+            io::OutputBuffer out;
+            document.RenderObjects(out, options);
+            return out.Release();
+        }
+
+        // Запас вокруг точки привязки подписи: смещение и высота шрифта
+        double LabelMargin(int font_size, svg::Point offset)
+        {
+            return std::max(std::abs(offset.x), std::abs(offset.y)) + font_size;
+        }
+    }
+
+    std::vector<svg::Point> SimplifyPolyline(const std::vector<svg::Point> &points, double tolerance)
+    {
+        if (points.size() < 3 || !(tolerance > 0.0))
+        {
+            return points;
+        }
+
+        // Рекурсия заменена стеком отрезков, чтобы длинные маршруты не переполняли стек вызовов
+        std::vector<bool> keep(points.size(), false);
+        keep.front() = true;
+        keep.back() = true;
+        std::vector<std::pair<size_t, size_t>> ranges{{0, points.size() - 1}};
+        while (!ranges.empty())
+        {
+            const auto [first, last] = ranges.back();
+            ranges.pop_back();
+
+            double max_distance = 0.0;
+            size_t farthest = first;
+            for (size_t i = first + 1; i < last; ++i)
+            {
+                const double distance = DistanceToSegment(points[i], points[first], points[last]);
+                if (distance > max_distance)
+                {
+                    max_distance = distance;
+                    farthest = i;
+                }
+            }
+
+            if (max_distance > tolerance)
+            {
+                keep[farthest] = true;
+                ranges.emplace_back(first, farthest);
+                ranges.emplace_back(farthest, last);
+            }
+        }
+
+        std::vector<svg::Point> result;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            if (keep[i])
+            {
+                result.push_back(points[i]);
+            }
+        }
+        return result;
+    }
+
+    // ---------- LabelPlacer ------------------
+
+    template <typename Callback>
+    void LabelPlacer::ForEachCell(const Rect &rect, Callback callback) const
+    {
+        const auto first_column = static_cast<int32_t>(std::floor(rect.min.x / cell_size_));
+        const auto last_column = static_cast<int32_t>(std::floor(rect.max.x / cell_size_));
+        const auto first_row = static_cast<int32_t>(std::floor(rect.min.y / cell_size_));
+        const auto last_row = static_cast<int32_t>(std::floor(rect.max.y / cell_size_));
+        for (int32_t row = first_row; row <= last_row; ++row)
+        {
+            for (int32_t column = first_column; column <= last_column; ++column)
+            {
+                callback((static_cast<uint64_t>(static_cast<uint32_t>(row)) << 32) | static_cast<uint32_t>(column));
+            }
+        }
+    }
+
+    bool LabelPlacer::TryPlace(const Rect &rect)
+    {
+        bool free = true;
+        ForEachCell(rect, [this, &rect, &free](uint64_t key)
+                    {
+            if (!free)
+            {
+                return;
+            }
+            const auto it = cells_.find(key);
+            if (it != cells_.end())
+            {
+                free = std::none_of(it->second.begin(), it->second.end(), [&rect](const Rect &placed)
+                                    { return placed.Intersects(rect); });
+            } });
+        if (!free)
+        {
+            return false;
+        }
+
+        ForEachCell(rect, [this, &rect](uint64_t key)
+                    { cells_[key].push_back(rect); });
+        return true;
+    }
+
+    // ---------- SphereProjector ------------------
+
+    CoordinateBounds ComputeBounds(const CoordinateBuffer &coordinates)
+    {
+        const size_t size = coordinates.Size();
+        const double *lat = coordinates.lat.data();
+        const double *lng = coordinates.lng.data();
+        CoordinateBounds bounds{lat[0], lat[0], lng[0], lng[0]};
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        // По две координаты за инструкцию; min и max не зависят от порядка, поэтому результат
+        // совпадает со скалярным проходом
+        if (size >= 2)
+        {
+            __m128d min_lat = _mm_loadu_pd(lat);
+            __m128d max_lat = min_lat;
+            __m128d min_lng = _mm_loadu_pd(lng);
+            __m128d max_lng = min_lng;
+            for (i = 2; i + 2 <= size; i += 2)
+            {
+                const __m128d lat_pair = _mm_loadu_pd(lat + i);
+                const __m128d lng_pair = _mm_loadu_pd(lng + i);
+                min_lat = _mm_min_pd(min_lat, lat_pair);
+                max_lat = _mm_max_pd(max_lat, lat_pair);
+                min_lng = _mm_min_pd(min_lng, lng_pair);
+                max_lng = _mm_max_pd(max_lng, lng_pair);
+            }
+
+            double pair[2];
+            _mm_storeu_pd(pair, min_lat);
+            bounds.min_lat = std::min(pair[0], pair[1]);
+            _mm_storeu_pd(pair, max_lat);
+            bounds.max_lat = std::max(pair[0], pair[1]);
+            _mm_storeu_pd(pair, min_lng);
+            bounds.min_lng = std::min(pair[0], pair[1]);
+            _mm_storeu_pd(pair, max_lng);
+            bounds.max_lng = std::max(pair[0], pair[1]);
+        }
+#endif
+
+        for (; i < size; ++i)
+        {
+            bounds.min_lat = std::min(bounds.min_lat, lat[i]);
+            bounds.max_lat = std::max(bounds.max_lat, lat[i]);
+            bounds.min_lng = std::min(bounds.min_lng, lng[i]);
+            bounds.max_lng = std::max(bounds.max_lng, lng[i]);
+        }
+        return bounds;
+    }
+
+    void SphereProjector::ProjectBatch(const CoordinateBuffer &coordinates, std::vector<svg::Point> &points) const
+    {
+        const size_t size = coordinates.Size();
+        const double *lat = coordinates.lat.data();
+        const double *lng = coordinates.lng.data();
+        points.resize(size);
+        size_t i = 0;
+
+        // С FMA компилятор вправе слить умножение и сложение в operator(), и округление разойдётся
+        // с раздельными инструкциями; тогда все точки считаются одним и тем же скалярным кодом
+#if defined(__SSE2__) && !defined(__FMA__)
+        static_assert(sizeof(svg::Point) == 2 * sizeof(double) && std::is_standard_layout_v<svg::Point>,
+                      "svg::Point must be two packed doubles");
+        const __m128d min_lon = _mm_set1_pd(min_lon_);
+        const __m128d max_lat = _mm_set1_pd(max_lat_);
+        const __m128d zoom = _mm_set1_pd(zoom_coeff_);
+        const __m128d padding = _mm_set1_pd(padding_);
+        // data(), а не &points[0]: при пустом наборе координат индексировать вектор нельзя
+        double *out = reinterpret_cast<double *>(points.data());
+        for (; i + 2 <= size; i += 2)
+        {
+            const __m128d x = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(lng + i), min_lon), zoom), padding);
+            const __m128d y = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(max_lat, _mm_loadu_pd(lat + i)), zoom), padding);
+            _mm_storeu_pd(out + 2 * i, _mm_unpacklo_pd(x, y));
+            _mm_storeu_pd(out + 2 * i + 2, _mm_unpackhi_pd(x, y));
+        }
+#endif
+
+        for (; i < size; ++i)
+        {
+            points[i] = (*this)({lat[i], lng[i]});
+        }
+    }
+
+    // ---------- MapIndex ------------------
+
+    MapIndex::MapIndex(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const RenderSettings &settings)
+        : MapIndex(buses, settings, CollectStops(buses))
+    {
+    }
+
+    MapIndex::MapIndex(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const RenderSettings &settings,
+                       const RouteStops &route_stops)
+        : projector_(MakeProjector(route_stops.coordinates, settings))
     {
-        std::vector<svg::Polyline> result;
         size_t color = 0;
+        size_t point_count = 0;
 
         for (const auto &[bus_name, bus] : buses)
         {
-            if (bus->stops_for_bus.empty())
+            const auto &bus_stops = bus->stops_for_bus;
+            if (bus_stops.empty())
                 continue;
 
-            std::vector<const transport_catalogue::Stop *> stops_route{bus->stops_for_bus.begin(), bus->stops_for_bus.end()};
+            BusEntry entry;
+            entry.bus = bus;
+            entry.color = color;
+            entry.points = ProjectRoute(*bus, projector_);
 
-            if (bus->is_roundtrip == false)
-                stops_route.insert(stops_route.end(), std::next(bus->stops_for_bus.rbegin()), bus->stops_for_bus.rend());
+            entry.labels.push_back(projector_(bus_stops[0]->coordinates));
+            if (!bus->is_roundtrip && bus_stops[0] != bus_stops.back())
+            {
+                entry.labels.push_back(projector_(bus_stops.back()->coordinates));
+            }
 
-            svg::Polyline line;
+            point_count += entry.points.size();
+            buses_.push_back(std::move(entry));
+            color = color + 1 < settings.color_palette.size() ? color + 1 : 0;
+        }
+
+        std::vector<svg::Point> stop_points;
+        projector_.ProjectBatch(route_stops.coordinates, stop_points);
+        stops_.reserve(route_stops.stops.size());
+        size_t stop_index = 0;
+        for (const auto &[stop_name, stop] : route_stops.stops)
+        {
+            stops_.push_back({stop, stop_points[stop_index++]});
+        }
+
+        // Сетка покрывает весь холст, в среднем несколько точек на ячейку
+        bounds_ = {{0.0, 0.0}, {std::max(settings.width, 1.0), std::max(settings.height, 1.0)}};
+        const size_t side = std::clamp<size_t>(static_cast<size_t>(std::sqrt(static_cast<double>(point_count + stops_.size()) / 4.0)), 1, 1024);
+        columns_ = side;
+        rows_ = side;
+        cell_width_ = bounds_.Width() / columns_;
+        cell_height_ = bounds_.Height() / rows_;
+        bus_cells_.resize(columns_ * rows_);
+        stop_cells_.resize(columns_ * rows_);
+
+        const auto add_bus = [this](size_t bus_index, svg::Point a, svg::Point b)
+        {
+            const size_t column_end = Column(std::max(a.x, b.x));
+            const size_t row_end = Row(std::max(a.y, b.y));
+            for (size_t row = Row(std::min(a.y, b.y)); row <= row_end; ++row)
+            {
+                for (size_t column = Column(std::min(a.x, b.x)); column <= column_end; ++column)
+                {
+                    auto &cell = bus_cells_[row * columns_ + column];
+                    // Отрезки маршрута добавляются подряд, поэтому повтор может быть только последним
+                    if (cell.empty() || cell.back() != bus_index)
+                    {
+                        cell.push_back(bus_index);
+                    }
+                }
+            }
+        };
 
-            for (const auto &stop : stops_route)
+        for (size_t bus_index = 0; bus_index < buses_.size(); ++bus_index)
+        {
+            const auto &points = buses_[bus_index].points;
+            add_bus(bus_index, points[0], points[0]);
+            for (size_t i = 1; i < points.size(); ++i)
             {
-                line.AddPoint(sphere_projector(stop->coordinates));
+                add_bus(bus_index, points[i - 1], points[i]);
             }
+        }
+
+        for (size_t stop_index = 0; stop_index < stops_.size(); ++stop_index)
+        {
+            const svg::Point point = stops_[stop_index].point;
+            stop_cells_[Row(point.y) * columns_ + Column(point.x)].push_back(stop_index);
+        }
+    }
+
+    size_t MapIndex::Column(double x) const
+    {
+        const double column = std::floor((x - bounds_.min.x) / cell_width_);
+        return static_cast<size_t>(std::clamp(column, 0.0, static_cast<double>(columns_ - 1)));
+    }
+
+    size_t MapIndex::Row(double y) const
+    {
+        const double row = std::floor((y - bounds_.min.y) / cell_height_);
+        return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+    }
+
+    Rect MapIndex::GetBoundingBoxRect(geo::Coordinates min, geo::Coordinates max) const
+    {
+        // Север наверху: большей широте соответствует меньшая координата y
+        const svg::Point top_left = projector_({max.lat, min.lng});
+        const svg::Point bottom_right = projector_({min.lat, max.lng});
+        return {{std::min(top_left.x, bottom_right.x), std::min(top_left.y, bottom_right.y)},
+                {std::max(top_left.x, bottom_right.x), std::max(top_left.y, bottom_right.y)}};
+    }
+
+    void MapIndex::Query(const Rect &rect, std::vector<size_t> &buses, std::vector<size_t> &stops) const
+    {
+        buses.clear();
+        stops.clear();
+        if (rect.max.x < bounds_.min.x || rect.min.x > bounds_.max.x || rect.max.y < bounds_.min.y || rect.min.y > bounds_.max.y)
+        {
+            return;
+        }
+
+        const size_t column_end = Column(rect.max.x);
+        const size_t row_end = Row(rect.max.y);
+        for (size_t row = Row(rect.min.y); row <= row_end; ++row)
+        {
+            for (size_t column = Column(rect.min.x); column <= column_end; ++column)
+            {
+                const size_t cell = row * columns_ + column;
+                buses.insert(buses.end(), bus_cells_[cell].begin(), bus_cells_[cell].end());
+                stops.insert(stops.end(), stop_cells_[cell].begin(), stop_cells_[cell].end());
+            }
+        }
+
+        std::sort(buses.begin(), buses.end());
+        buses.erase(std::unique(buses.begin(), buses.end()), buses.end());
+        std::sort(stops.begin(), stops.end());
+    }
+
+    size_t MapIndex::GetMemoryUsage() const
+    {
+        size_t bytes = memory::VectorBytes(buses_) + memory::VectorBytes(stops_) +
+                       memory::VectorBytes(bus_cells_) + memory::VectorBytes(stop_cells_);
+        for (const auto &entry : buses_)
+        {
+            bytes += memory::VectorBytes(entry.points) + memory::VectorBytes(entry.labels);
+        }
+        for (const auto &cell : bus_cells_)
+        {
+            bytes += memory::VectorBytes(cell);
+        }
+        for (const auto &cell : stop_cells_)
+        {
+            bytes += memory::VectorBytes(cell);
+        }
+        return bytes;
+    }
+
+    // ---------- MapCache ------------------
+
+    void MapCache::Render(io::OutputBuffer &out) const
+    {
+        svg::Document::RenderBegin(out);
+        out.Write(style_);
+        for (const auto &[name, fragments] : buses_)
+        {
+            out.Write(fragments.line);
+        }
+        std::optional<LabelPlacer> placer;
+        if (lod_tolerance_ > 0.0)
+        {
+            placer.emplace();
+        }
+        for (const auto &[name, fragments] : buses_)
+        {
+            for (const auto &label : fragments.labels)
+            {
+                if (!placer || placer->TryPlace(label.rect))
+                {
+                    out.Write(label.svg);
+                }
+            }
+        }
+        for (const auto &[name, fragments] : stops_)
+        {
+            out.Write(fragments.circle);
+        }
+        for (const auto &[name, fragments] : stops_)
+        {
+            if (!fragments.label.svg.empty() && (!placer || placer->TryPlace(fragments.label.rect)))
+            {
+                out.Write(fragments.label.svg);
+            }
+        }
+        svg::Document::RenderEnd(out);
+    }
+
+    size_t MapCache::GetMemoryUsage() const
+    {
+        size_t bytes = memory::TreeNodesBytes(buses_) + memory::TreeNodesBytes(stops_) + memory::StringBytes(style_);
+        for (const auto &[name, fragments] : buses_)
+        {
+            bytes += memory::StringBytes(name) + memory::VectorBytes(fragments.stops) + memory::VectorBytes(fragments.points) +
+                     memory::StringBytes(fragments.line) + memory::VectorBytes(fragments.labels);
+            for (const auto &label : fragments.labels)
+            {
+                bytes += memory::StringBytes(label.svg);
+            }
+        }
+        for (const auto &[name, fragments] : stops_)
+        {
+            bytes += memory::StringBytes(name) + memory::StringBytes(fragments.circle) + memory::StringBytes(fragments.label.svg);
+        }
+        return bytes;
+    }
+
+    std::optional<MapCache::SegmentPoints> MapCache::FindSegment(const RouteSegment &segment) const
+    {
+        const auto it = buses_.find(segment.bus);
+        if (it == buses_.end())
+        {
+            return std::nullopt;
+        }
+
+        // Ломаная некольцевого маршрута продолжается остановками в обратном порядке без повтора конечной
+        const auto &fragments = it->second;
+        const auto &stops = fragments.stops;
+        const auto stop_at = [&stops](size_t index)
+        {
+            return index < stops.size() ? stops[index] : stops[2 * stops.size() - 2 - index];
+        };
+
+        const auto &points = fragments.points;
+        for (size_t first = 0; first + segment.span_count < points.size(); ++first)
+        {
+            if (stop_at(first) == segment.from && stop_at(first + segment.span_count) == segment.to)
+            {
+                return SegmentPoints{{points.begin() + first, points.begin() + first + segment.span_count + 1}, fragments.color};
+            }
+        }
+        return std::nullopt;
+    }
+
+    // ---------- MapRenderer ------------------
+
+    size_t MapRenderer::NextColor(size_t color) const
+    {
+        return color < (render_settings_.color_palette.size() - 1) ? color + 1 : 0;
+    }
+
+    Rect MapRenderer::EstimateLabelRect(svg::Point position, svg::Point offset, int font_size, std::string_view text) const
+    {
+        // Точка подписи — левый край базовой линии текста
+        const double left = position.x + offset.x;
+        const double baseline = position.y + offset.y;
+        const double width = LABEL_CHAR_WIDTH * font_size * static_cast<double>(CountCharacters(text));
+        return {{left, baseline - font_size}, {left + width, baseline}};
+    }
+
+    bool MapRenderer::PlaceLabel(LabelPlacer *placer, const Rect &rect, int font_size) const
+    {
+        if (!placer)
+        {
+            return true;
+        }
+        return font_size >= MIN_LABEL_FONT_SIZE && placer->TryPlace(rect);
+    }
+
+    svg::Style MapRenderer::MakeStyle() const
+    {
+        using namespace std::literals;
+        io::OutputBuffer css;
+        const svg::BufferContext context(css, render_settings_.svg_options);
+
+        css.Write(".r{fill:none;stroke-width:"sv);
+        context.WriteNumber(render_settings_.line_width);
+        css.Write(";stroke-linecap:round;stroke-linejoin:round}"sv);
 
+        // Обводка рисуется под заливкой и играет роль подложки
+        css.Write(".b,.s{font-family:Verdana;stroke:"sv);
+        svg::RenderColor(render_settings_.underlayer_color, context);
+        css.Write(";stroke-width:"sv);
+        context.WriteNumber(render_settings_.underlayer_width);
+        css.Write(";stroke-linecap:round;stroke-linejoin:round;paint-order:stroke}"sv);
+
+        css.Write(".b{font-size:"sv);
+        css.WriteInt(render_settings_.bus_label_font_size);
+        css.Write("px;font-weight:bold}.s{font-size:"sv);
+        css.WriteInt(render_settings_.stop_label_font_size);
+        css.Write("px;fill:black}.c{fill:white}"sv);
+
+        return svg::Style(css.Release());
+    }
+
+    svg::Polyline MapRenderer::MakeRouteLine(size_t color) const
+    {
+        svg::Polyline line;
+        if (render_settings_.svg_compact)
+        {
+            line.SetClass("r");
             line.SetStrokeColor(render_settings_.color_palette[color]);
-            line.SetFillColor("none");
-            line.SetStrokeWidth(render_settings_.line_width);
-            line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-            line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+            return line;
+        }
+        line.SetStrokeColor(render_settings_.color_palette[color]);
+        line.SetFillColor("none");
+        line.SetStrokeWidth(render_settings_.line_width);
+        line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+        line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+        return line;
+    }
 
-            if (color < (render_settings_.color_palette.size() - 1))
-                ++color;
-            else
-                color = 0;
+    template <typename Container>
+    void MapRenderer::AddBusLabel(svg::Point position, const std::string &name, size_t color, Container &result) const
+    {
+        if (render_settings_.svg_compact)
+        {
+            svg::Text text;
+            text.SetClass("b");
+            text.SetFillColor(render_settings_.color_palette[color]);
+            text.SetPosition(position);
+            text.SetOffset(render_settings_.bus_label_offset);
+            text.SetFontSize(std::nullopt);
+            text.SetData(name);
+            result.Add(std::move(text));
+            return;
+        }
+
+        svg::Text text;
+        text.SetPosition(position);
+        text.SetOffset(render_settings_.bus_label_offset);
+        text.SetFontSize(static_cast<uint32_t>(render_settings_.bus_label_font_size));
+        text.SetFontFamily("Verdana");
+        text.SetFontWeight("bold");
+        text.SetData(name);
+
+        svg::Text substrate{text};
+        substrate.SetFillColor(render_settings_.underlayer_color);
+        substrate.SetStrokeColor(render_settings_.underlayer_color);
+        substrate.SetStrokeWidth(render_settings_.underlayer_width);
+        substrate.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+        substrate.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+
+        text.SetFillColor(render_settings_.color_palette[color]);
 
-            result.push_back(line);
+        result.Add(std::move(substrate));
+        result.Add(std::move(text));
+    }
+
+    template <typename Container>
+    void MapRenderer::AddStopPoint(svg::Point position, Container &result) const
+    {
+        svg::Circle circle;
+        circle.SetCenter(position);
+        circle.SetRadius(render_settings_.stop_radius);
+        if (render_settings_.svg_compact)
+        {
+            circle.SetClass("c");
         }
-        return result;
+        else
+        {
+            circle.SetFillColor("white");
+        }
+        result.Add(std::move(circle));
+    }
+
+    template <typename Container>
+    void MapRenderer::AddStopLabel(svg::Point position, const std::string &name, Container &result) const
+    {
+        if (render_settings_.svg_compact)
+        {
+            svg::Text text;
+            text.SetClass("s");
+            text.SetPosition(position);
+            text.SetOffset(render_settings_.stop_label_offset);
+            text.SetFontSize(std::nullopt);
+            text.SetData(name);
+            result.Add(std::move(text));
+            return;
+        }
+
+        svg::Text text;
+        text.SetPosition(position);
+        text.SetOffset(render_settings_.stop_label_offset);
+        text.SetFontSize(static_cast<uint32_t>(render_settings_.stop_label_font_size));
+        text.SetFontFamily("Verdana");
+        text.SetData(name);
+
+        svg::Text substrate{text};
+        substrate.SetFillColor(render_settings_.underlayer_color);
+        substrate.SetStrokeColor(render_settings_.underlayer_color);
+        substrate.SetStrokeWidth(render_settings_.underlayer_width);
+        substrate.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+        substrate.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+
+        text.SetFillColor("black");
+
+        result.Add(std::move(substrate));
+        result.Add(std::move(text));
     }
 
-    std::vector<svg::Text> MapRenderer::GetNamesRoute(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const SphereProjector &sp) const
+    template <typename Container>
+    void MapRenderer::AddRouteLines(const std::map<std::string_view, const transport_catalogue ::Bus *> &buses, const SphereProjector &sphere_projector, Container &result) const
     {
-        std::vector<svg::Text> result;
         size_t color = 0;
 
         for (const auto &[bus_name, bus] : buses)
         {
             if (bus->stops_for_bus.empty())
                 continue;
-            svg::Text text;
-            text.SetPosition(sp(bus->stops_for_bus[0]->coordinates));
-            text.SetOffset(render_settings_.bus_label_offset);
-            text.SetFontSize(static_cast<uint32_t>(render_settings_.bus_label_font_size));
-            text.SetFontFamily("Verdana");
-            text.SetFontWeight("bold");
-            text.SetData(bus->name_bus);
-            text.SetFillColor(render_settings_.color_palette[color]);
 
-            if (color < (render_settings_.color_palette.size() - 1))
-                ++color;
-            else
-                color = 0;
-
-            svg::Text substrate;
-            substrate.SetPosition(sp(bus->stops_for_bus[0]->coordinates));
-            substrate.SetOffset(render_settings_.bus_label_offset);
-            substrate.SetFontSize(static_cast<uint32_t>(render_settings_.bus_label_font_size));
-            substrate.SetFontFamily("Verdana");
-            substrate.SetFontWeight("bold");
-            substrate.SetData(bus->name_bus);
-            substrate.SetFillColor(render_settings_.underlayer_color);
-            substrate.SetStrokeColor(render_settings_.underlayer_color);
-            substrate.SetStrokeWidth(render_settings_.underlayer_width);
-            substrate.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-            substrate.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+            std::vector<svg::Point> points = ProjectRoute(*bus, sphere_projector);
+            if (render_settings_.lod_tolerance > 0.0)
+            {
+                points = SimplifyPolyline(points, render_settings_.lod_tolerance);
+            }
 
-            result.push_back(substrate);
-            result.push_back(text);
+            svg::Polyline line = MakeRouteLine(color);
+            line.ReservePoints(points.size());
+            for (const auto &point : points)
+            {
+                line.AddPoint(point);
+            }
 
+            color = NextColor(color);
+            result.Add(std::move(line));
+        }
+    }
+
+    template <typename Container>
+    void MapRenderer::AddNamesRoute(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const SphereProjector &sp, Container &result, LabelPlacer *placer) const
+    {
+        size_t color = 0;
+        const int font_size = render_settings_.bus_label_font_size;
+
+        for (const auto &[bus_name, bus] : buses)
+        {
+            if (bus->stops_for_bus.empty())
+                continue;
+
+            const svg::Point first = sp(bus->stops_for_bus[0]->coordinates);
+            if (PlaceLabel(placer, EstimateLabelRect(first, render_settings_.bus_label_offset, font_size, bus->name_bus), font_size))
+            {
+                AddBusLabel(first, bus->name_bus, color, result);
+            }
             if (!bus->is_roundtrip && bus->stops_for_bus[0] != bus->stops_for_bus.back())
             {
-                svg::Text text2{text};
-                svg::Text substrate2{substrate};
-                text2.SetPosition(sp(bus->stops_for_bus.back()->coordinates));
-                substrate2.SetPosition(sp(bus->stops_for_bus.back()->coordinates));
-
-                result.push_back(substrate2);
-                result.push_back(text2);
+                const svg::Point last = sp(bus->stops_for_bus.back()->coordinates);
+                if (PlaceLabel(placer, EstimateLabelRect(last, render_settings_.bus_label_offset, font_size, bus->name_bus), font_size))
+                {
+                    AddBusLabel(last, bus->name_bus, color, result);
+                }
             }
+
+            color = NextColor(color);
         }
+    }
 
-        return result;
+    template <typename Container>
+    void MapRenderer::AddStopCircle(const std::vector<svg::Point> &stop_points, Container &result) const
+    {
+        for (const auto &point : stop_points)
+        {
+            AddStopPoint(point, result);
+        }
     }
 
-    std::vector<svg::Circle> MapRenderer::GetStopCircle(const std::map<std::string_view, const transport_catalogue::Stop *> &stops, const SphereProjector &sp) const
+    template <typename Container>
+    void MapRenderer::AddNamesStops(const std::map<std::string_view, const transport_catalogue::Stop *> &stops, const std::vector<svg::Point> &stop_points, Container &result, LabelPlacer *placer) const
     {
-        std::vector<svg::Circle> result;
+        const int font_size = render_settings_.stop_label_font_size;
 
+        size_t stop_index = 0;
         for (const auto &[stop_name, stop] : stops)
         {
-            svg::Circle circle;
-            circle.SetCenter(sp(stop->coordinates));
-            circle.SetRadius(render_settings_.stop_radius);
-            circle.SetFillColor("white");
-            result.push_back(circle);
+            const svg::Point position = stop_points[stop_index++];
+            if (stop->passing_buses.empty())
+                continue;
+            if (PlaceLabel(placer, EstimateLabelRect(position, render_settings_.stop_label_offset, font_size, stop->name_stop), font_size))
+            {
+                AddStopLabel(position, stop->name_stop, result);
+            }
         }
+    }
 
+    svg::Document MapRenderer::GetDocumentSVG(const std::map<std::string_view, const transport_catalogue::Bus *> &buses) const
+    {
+        svg::Document result;
+        DrawMap(buses, result);
         return result;
     }
 
-    std::vector<svg::Text> MapRenderer::GetNamesStops(const std::map<std::string_view, const transport_catalogue::Stop *> &stops, const SphereProjector &sp) const
+    void MapRenderer::RenderMap(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, io::OutputBuffer &out) const
+    {
+        svg::DocumentWriter writer(out, render_settings_.svg_options);
+        DrawMap(buses, writer);
+        writer.Finish();
+    }
+
+    template <typename Container>
+    void MapRenderer::DrawMap(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, Container &result) const
+    {
+        const auto [stops, coordinates] = CollectStops(buses);
+        const SphereProjector sphere_projector = MakeProjector(coordinates, render_settings_);
+        std::vector<svg::Point> stop_points;
+        sphere_projector.ProjectBatch(coordinates, stop_points);
+
+        if constexpr (std::is_same_v<Container, svg::Document>)
+        {
+            // Линия и до четырёх подписей на маршрут, круг и две подписи на остановку
+            result.Reserve(buses.size() * 5 + stops.size() * 3 + 1);
+        }
+        if (render_settings_.svg_compact)
+        {
+            result.Add(MakeStyle());
+        }
+        std::optional<LabelPlacer> placer;
+        if (render_settings_.lod_tolerance > 0.0)
+        {
+            placer.emplace();
+        }
+        LabelPlacer *const label_placer = placer ? &*placer : nullptr;
+
+        AddRouteLines(buses, sphere_projector, result);
+        AddNamesRoute(buses, sphere_projector, result, label_placer);
+        AddStopCircle(stop_points, result);
+        AddNamesStops(stops, stop_points, result, label_placer);
+    }
+
+    void MapRenderer::BuildBusFragments(const transport_catalogue::Bus &bus, size_t color, const SphereProjector &projector, MapCache::BusFragments &fragments) const
+    {
+        const svg::RenderOptions &options = render_settings_.svg_options;
+        const bool lod = render_settings_.lod_tolerance > 0.0;
+        const auto &bus_stops = bus.stops_for_bus;
+
+        fragments.stops = bus_stops;
+        fragments.is_roundtrip = bus.is_roundtrip;
+        fragments.color = color;
+        fragments.points = ProjectRoute(bus, projector);
+
+        std::vector<svg::Point> simplified;
+        const auto &line_points = lod ? (simplified = SimplifyPolyline(fragments.points, render_settings_.lod_tolerance)) : fragments.points;
+        svg::Polyline line = MakeRouteLine(color);
+        line.ReservePoints(line_points.size());
+        for (const auto &point : line_points)
+        {
+            line.AddPoint(point);
+        }
+        svg::Document line_document;
+        line_document.Add(std::move(line));
+        fragments.line = RenderFragment(line_document, options);
+
+        const int font_size = render_settings_.bus_label_font_size;
+        if (lod && font_size < MIN_LABEL_FONT_SIZE)
+        {
+            return;
+        }
+        std::vector<svg::Point> label_points{fragments.points[0]};
+        if (!bus.is_roundtrip && bus_stops[0] != bus_stops.back())
+        {
+            label_points.push_back(projector(bus_stops.back()->coordinates));
+        }
+        for (const auto &position : label_points)
+        {
+            svg::Document label_document;
+            AddBusLabel(position, bus.name_bus, color, label_document);
+            fragments.labels.push_back({EstimateLabelRect(position, render_settings_.bus_label_offset, font_size, bus.name_bus),
+                                        RenderFragment(label_document, options)});
+        }
+    }
+
+    void MapRenderer::BuildStopFragments(const transport_catalogue::Stop &stop, svg::Point point, MapCache::StopFragments &fragments) const
     {
-        std::vector<svg::Text> result;
+        const svg::RenderOptions &options = render_settings_.svg_options;
+        const bool lod = render_settings_.lod_tolerance > 0.0;
+
+        fragments.coordinates = stop.coordinates;
+        fragments.has_label = !stop.passing_buses.empty();
 
+        svg::Document circle_document;
+        AddStopPoint(point, circle_document);
+        fragments.circle = RenderFragment(circle_document, options);
+
+        const int font_size = render_settings_.stop_label_font_size;
+        if (fragments.has_label && !(lod && font_size < MIN_LABEL_FONT_SIZE))
+        {
+            svg::Document label_document;
+            AddStopLabel(point, stop.name_stop, label_document);
+            fragments.label = {EstimateLabelRect(point, render_settings_.stop_label_offset, font_size, stop.name_stop),
+                               RenderFragment(label_document, options)};
+        }
+    }
+
+    void MapRenderer::UpdateCache(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, MapCache &cache, parallel::ThreadPool *pool) const
+    {
+        const svg::RenderOptions &options = render_settings_.svg_options;
+        const auto [stops, coordinates] = CollectStops(buses);
+        const SphereProjector projector = MakeProjector(coordinates, render_settings_);
+
+        // Новая проекция или формат чисел меняют все фрагменты
+        if (!cache.projector_ || !(*cache.projector_ == projector) || !(cache.options_ == options) ||
+            cache.lod_tolerance_ != render_settings_.lod_tolerance || cache.compact_ != render_settings_.svg_compact)
+        {
+            cache.buses_.clear();
+            cache.stops_.clear();
+            cache.projector_ = projector;
+            cache.options_ = options;
+            cache.lod_tolerance_ = render_settings_.lod_tolerance;
+            cache.compact_ = render_settings_.svg_compact;
+
+            cache.style_.clear();
+            if (cache.compact_)
+            {
+                svg::Document style_document;
+                style_document.Add(MakeStyle());
+                cache.style_ = RenderFragment(style_document, options);
+            }
+        }
+
+        // Этап 1, последовательный: неизменившиеся фрагменты переносятся в новые словари,
+        // для остальных заводятся пустые записи. Узлы std::map не перемещаются при вставке,
+        // поэтому на этапе 2 записи заполняются по указателям без синхронизации
+        struct BusJob
+        {
+            const transport_catalogue::Bus *bus;
+            size_t color;
+            MapCache::BusFragments *fragments;
+        };
+        struct StopJob
+        {
+            const transport_catalogue::Stop *stop;
+            svg::Point point;
+            MapCache::StopFragments *fragments;
+        };
+        std::vector<BusJob> bus_jobs;
+        std::vector<StopJob> stop_jobs;
+
+        // Указатели на остановки могут совпасть, а координаты остановок — измениться; прежние координаты
+        // каждой остановки маршрута хранятся во фрагментах остановок, которые на этом этапе ещё не обновлены
+        const auto same_coordinates = [&cache](const std::vector<const transport_catalogue::Stop *> &bus_stops)
+        {
+            return std::all_of(bus_stops.begin(), bus_stops.end(), [&cache](const transport_catalogue::Stop *stop)
+                               {
+                const auto it = cache.stops_.find(stop->name_stop);
+                return it != cache.stops_.end() && it->second.coordinates == stop->coordinates; });
+        };
+
+        // Маршруты идут по возрастанию имён, поэтому вставка в конец нового словаря не требует поиска
+        std::map<std::string, MapCache::BusFragments, std::less<>> bus_fragments;
+        size_t color = 0;
+
+        for (const auto &[bus_name, bus] : buses)
+        {
+            const auto &bus_stops = bus->stops_for_bus;
+            if (bus_stops.empty())
+                continue;
+
+            if (const auto it = cache.buses_.find(bus_name); it != cache.buses_.end() &&
+                                                             it->second.stops == bus_stops &&
+                                                             it->second.is_roundtrip == bus->is_roundtrip &&
+                                                             it->second.color == color &&
+                                                             same_coordinates(bus_stops))
+            {
+                bus_fragments.insert(bus_fragments.end(), cache.buses_.extract(it));
+            }
+            else
+            {
+                const auto inserted = bus_fragments.emplace_hint(bus_fragments.end(), bus->name_bus, MapCache::BusFragments{});
+                bus_jobs.push_back({bus, color, &inserted->second});
+            }
+
+            color = NextColor(color);
+        }
+        cache.buses_ = std::move(bus_fragments);
+
+        // Точки остановок проецируются одним проходом по буферу; пересчитываются из них только изменившиеся
+        std::vector<svg::Point> stop_points;
+        projector.ProjectBatch(coordinates, stop_points);
+        std::map<std::string, MapCache::StopFragments, std::less<>> stop_fragments;
+        size_t stop_index = 0;
         for (const auto &[stop_name, stop] : stops)
         {
-            if (stop->passing_buses.empty())
+            const svg::Point point = stop_points[stop_index++];
+            if (const auto it = cache.stops_.find(stop_name); it != cache.stops_.end() &&
+                                                              it->second.coordinates == stop->coordinates &&
+                                                              it->second.has_label == !stop->passing_buses.empty())
+            {
+                stop_fragments.insert(stop_fragments.end(), cache.stops_.extract(it));
+            }
+            else
+            {
+                const auto inserted = stop_fragments.emplace_hint(stop_fragments.end(), stop->name_stop, MapCache::StopFragments{});
+                stop_jobs.push_back({stop, point, &inserted->second});
+            }
+        }
+        cache.stops_ = std::move(stop_fragments);
+
+        // Этап 2: фрагменты маршрутов и остановок, то есть всех четырёх слоёв, отрисовываются
+        // независимо друг от друга, в пуле потоков — частями общего диапазона заданий
+        const auto build = [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (i < bus_jobs.size())
+                {
+                    BuildBusFragments(*bus_jobs[i].bus, bus_jobs[i].color, projector, *bus_jobs[i].fragments);
+                }
+                else
+                {
+                    const StopJob &job = stop_jobs[i - bus_jobs.size()];
+                    BuildStopFragments(*job.stop, job.point, *job.fragments);
+                }
+            }
+        };
+        const size_t job_count = bus_jobs.size() + stop_jobs.size();
+        if (pool && job_count > FRAGMENT_CHUNK_SIZE)
+        {
+            pool->ParallelFor(job_count, FRAGMENT_CHUNK_SIZE, build);
+        }
+        else
+        {
+            build(0, job_count);
+        }
+        cache.rebuilt_ = job_count;
+    }
+
+    svg::Document MapRenderer::GetRouteOverlay(const MapCache &cache, const std::vector<RouteSegment> &segments) const
+    {
+        svg::Document result;
+        std::vector<svg::Point> stops_points;
+        result.Reserve(segments.size() * 4);
+
+        for (const auto &segment : segments)
+        {
+            const auto found = cache.FindSegment(segment);
+            if (!found)
+            {
                 continue;
-            svg::Text text;
-            text.SetPosition(sp(stop->coordinates));
-            text.SetOffset(render_settings_.stop_label_offset);
-            text.SetFontSize(static_cast<uint32_t>(render_settings_.stop_label_font_size));
-            text.SetFontFamily("Verdana");
-            text.SetData(stop->name_stop);
-            text.SetFillColor("black");
-
-            svg::Text substrate;
-            substrate.SetPosition(sp(stop->coordinates));
-            substrate.SetOffset(render_settings_.stop_label_offset);
-            substrate.SetFontSize(static_cast<uint32_t>(render_settings_.stop_label_font_size));
-            substrate.SetFontFamily("Verdana");
-            substrate.SetData(stop->name_stop);
-            substrate.SetFillColor(render_settings_.underlayer_color);
+            }
+
+            svg::Polyline substrate;
+            substrate.SetFillColor("none");
             substrate.SetStrokeColor(render_settings_.underlayer_color);
-            substrate.SetStrokeWidth(render_settings_.underlayer_width);
+            substrate.SetStrokeWidth(render_settings_.line_width + 2 * render_settings_.underlayer_width);
             substrate.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
             substrate.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-            result.push_back(substrate);
-            result.push_back(text);
+            svg::Polyline line;
+            line.SetFillColor("none");
+            line.SetStrokeColor(render_settings_.color_palette[found->color]);
+            line.SetStrokeWidth(render_settings_.line_width);
+            line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+            line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+
+            substrate.ReservePoints(found->points.size());
+            line.ReservePoints(found->points.size());
+            for (const auto &point : found->points)
+            {
+                substrate.AddPoint(point);
+                line.AddPoint(point);
+            }
+
+            result.Add(std::move(substrate));
+            result.Add(std::move(line));
+            // На пересадке начало участка совпадает с концом предыдущего: круг выводится один раз
+            const svg::Point &start = found->points.front();
+            if (stops_points.empty() || stops_points.back().x != start.x || stops_points.back().y != start.y)
+            {
+                stops_points.push_back(start);
+            }
+            stops_points.push_back(found->points.back());
+        }
+
+        // Круги поверх всех участков, чтобы пересадки не перекрывались линиями
+        for (const auto &point : stops_points)
+        {
+            AddStopPoint(point, result);
         }
 
         return result;
     }
 
-    svg::Document MapRenderer::GetDocumentSVG(const std::map<std::string_view, const transport_catalogue::Bus *> &buses) const
+    Rect MapRenderer::GetTileRect(int zoom, int x, int y) const
+    {
+        if (zoom < 0 || zoom > 30)
+        {
+            throw std::logic_error("wrong tile zoom");
+        }
+        const long long tiles = 1LL << zoom;
+        if (x < 0 || y < 0 || x >= tiles || y >= tiles)
+        {
+            throw std::logic_error("wrong tile coordinates");
+        }
+
+        const double tile_width = render_settings_.width / static_cast<double>(tiles);
+        const double tile_height = render_settings_.height / static_cast<double>(tiles);
+        return {{x * tile_width, y * tile_height}, {(x + 1) * tile_width, (y + 1) * tile_height}};
+    }
+
+    svg::Document MapRenderer::GetViewportSVG(const MapIndex &index, const Rect &viewport) const
     {
         svg::Document result;
-        std::vector<geo::Coordinates> coordinates_route;
-        std::map<std::string_view, const transport_catalogue::Stop *> stops;
+        DrawViewport(index, viewport, result);
+        return result;
+    }
 
-        for (const auto &[bus_name, bus] : buses)
+    void MapRenderer::RenderViewport(const MapIndex &index, const Rect &viewport, io::OutputBuffer &out) const
+    {
+        svg::DocumentWriter writer(out, render_settings_.svg_options);
+        DrawViewport(index, viewport, writer);
+        writer.Finish();
+    }
+
+    template <typename Container>
+    void MapRenderer::DrawViewport(const MapIndex &index, const Rect &viewport, Container &result) const
+    {
+        if (!(viewport.Width() > 0.0) || !(viewport.Height() > 0.0))
         {
-            if (bus->stops_for_bus.empty())
-                continue;
-            for (const auto &stop : bus->stops_for_bus)
-            {
-                coordinates_route.push_back(stop->coordinates);
-                stops[stop->name_stop] = stop;
-            }
+            return;
         }
 
-        SphereProjector sphere_projector(coordinates_route.begin(), coordinates_route.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
+        const double scale = std::min(render_settings_.width / viewport.Width(), render_settings_.height / viewport.Height());
+        const auto to_canvas = [&viewport, scale](svg::Point point)
+        {
+            return svg::Point{(point.x - viewport.min.x) * scale, (point.y - viewport.min.y) * scale};
+        };
+
+        // Запасы переводятся из пикселей холста в координаты полной карты,
+        // чтобы частично попадающие в область объекты не пропадали у её границы
+        const double line_margin = render_settings_.line_width / 2 / scale;
+        const double stop_margin = render_settings_.stop_radius / scale;
+        const double bus_label_margin = LabelMargin(render_settings_.bus_label_font_size, render_settings_.bus_label_offset) / scale;
+        const double stop_label_margin = LabelMargin(render_settings_.stop_label_font_size, render_settings_.stop_label_offset) / scale;
+
+        std::vector<size_t> bus_candidates;
+        std::vector<size_t> stop_candidates;
+        index.Query(viewport.Expanded(std::max({line_margin, stop_margin, bus_label_margin, stop_label_margin})), bus_candidates, stop_candidates);
+
+        const auto &buses = index.GetBuses();
+        const auto &stops = index.GetStops();
+        if constexpr (std::is_same_v<Container, svg::Document>)
+        {
+            result.Reserve(bus_candidates.size() * 5 + stop_candidates.size() * 3 + 1);
+        }
+        if (render_settings_.svg_compact)
+        {
+            result.Add(MakeStyle());
+        }
 
-        for (const auto &polyline : GetRouteLines(buses, sphere_projector))
+        // Допуск упрощения задан в пикселях холста
+        const double lod_tolerance = render_settings_.lod_tolerance / scale;
+        std::optional<LabelPlacer> placer;
+        if (lod_tolerance > 0.0)
         {
-            result.Add(polyline);
+            placer.emplace();
         }
+        LabelPlacer *const label_placer = placer ? &*placer : nullptr;
 
-        for (const auto &text : GetNamesRoute(buses, sphere_projector))
+        const Rect line_rect = viewport.Expanded(line_margin);
+        for (const size_t bus_index : bus_candidates)
         {
-            result.Add(text);
+            std::vector<svg::Point> simplified;
+            const auto &points = lod_tolerance > 0.0 ? (simplified = SimplifyPolyline(buses[bus_index].points, lod_tolerance)) : buses[bus_index].points;
+            for (const auto &piece : ClipPolyline(points, line_rect))
+            {
+                svg::Polyline line = MakeRouteLine(buses[bus_index].color);
+                line.ReservePoints(piece.size());
+                for (const auto &point : piece)
+                {
+                    line.AddPoint(to_canvas(point));
+                }
+                result.Add(std::move(line));
+            }
         }
 
-        for (const auto &circle : GetStopCircle(stops, sphere_projector))
+        for (const size_t bus_index : bus_candidates)
         {
-            result.Add(circle);
+            const auto &entry = buses[bus_index];
+            for (const auto &label : entry.labels)
+            {
+                if (!viewport.Contains(label, bus_label_margin))
+                {
+                    continue;
+                }
+                const svg::Point position = to_canvas(label);
+                const int font_size = render_settings_.bus_label_font_size;
+                if (PlaceLabel(label_placer, EstimateLabelRect(position, render_settings_.bus_label_offset, font_size, entry.bus->name_bus), font_size))
+                {
+                    AddBusLabel(position, entry.bus->name_bus, entry.color, result);
+                }
+            }
         }
 
-        for (const auto &text : GetNamesStops(stops, sphere_projector))
+        for (const size_t stop_index : stop_candidates)
         {
-            result.Add(text);
+            if (viewport.Contains(stops[stop_index].point, stop_margin))
+            {
+                AddStopPoint(to_canvas(stops[stop_index].point), result);
+            }
         }
 
-        return result;
+        for (const size_t stop_index : stop_candidates)
+        {
+            const auto &entry = stops[stop_index];
+            if (entry.stop->passing_buses.empty() || !viewport.Contains(entry.point, stop_label_margin))
+            {
+                continue;
+            }
+            const svg::Point position = to_canvas(entry.point);
+            const int font_size = render_settings_.stop_label_font_size;
+            if (PlaceLabel(label_placer, EstimateLabelRect(position, render_settings_.stop_label_offset, font_size, entry.stop->name_stop), font_size))
+            {
+                AddStopLabel(position, entry.stop->name_stop, result);
+            }
+        }
     }
-}
\ No newline at end of file
+}
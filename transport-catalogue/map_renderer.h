@@ -3,13 +3,18 @@
 #include "svg.h"
 #include "geo.h"
 #include "domain.h"
+#include "thread_pool.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <optional>
 #include <vector>
 #include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace renderer
 {
@@ -21,6 +26,42 @@ namespace renderer
         return std::abs(value) < EPSILON;
     }
 
+    // Координаты в виде структуры массивов: широты и долготы лежат в отдельных непрерывных
+    // массивах, поэтому границы и проекция считаются векторными инструкциями
+    struct CoordinateBuffer
+    {
+        std::vector<double> lat;
+        std::vector<double> lng;
+
+        void Reserve(size_t count)
+        {
+            lat.reserve(count);
+            lng.reserve(count);
+        }
+
+        void Add(geo::Coordinates coordinates)
+        {
+            lat.push_back(coordinates.lat);
+            lng.push_back(coordinates.lng);
+        }
+
+        size_t Size() const
+        {
+            return lat.size();
+        }
+    };
+
+    struct CoordinateBounds
+    {
+        double min_lat = 0.0;
+        double max_lat = 0.0;
+        double min_lng = 0.0;
+        double max_lng = 0.0;
+    };
+
+    // Границы широт и долгот за один проход по буферу; буфер не должен быть пустым
+    CoordinateBounds ComputeBounds(const CoordinateBuffer &coordinates);
+
     class SphereProjector
     {
     public:
@@ -41,29 +82,69 @@ namespace renderer
                 points_begin, points_end,
                 [](auto lhs, auto rhs)
                 { return lhs.lng < rhs.lng; });
-            min_lon_ = left_it->lng;
-            const double max_lon = right_it->lng;
 
             // Находим точки с минимальной и максимальной широтой
             const auto [bottom_it, top_it] = std::minmax_element(
                 points_begin, points_end,
                 [](auto lhs, auto rhs)
                 { return lhs.lat < rhs.lat; });
-            const double min_lat = bottom_it->lat;
-            max_lat_ = top_it->lat;
+
+            SetBounds({bottom_it->lat, top_it->lat, left_it->lng, right_it->lng}, max_width, max_height);
+        }
+
+        // То же по буферу координат (например, остановок без повторов): границы считаются за один проход
+        SphereProjector(const CoordinateBuffer &coordinates, double max_width, double max_height, double padding)
+            : padding_(padding)
+        {
+            if (coordinates.Size() != 0)
+            {
+                SetBounds(ComputeBounds(coordinates), max_width, max_height);
+            }
+        }
+
+        // Проецирует широту и долготу в координаты внутри SVG-изображения
+        svg::Point operator()(geo::Coordinates coords) const
+        {
+            return {
+                (coords.lng - min_lon_) * zoom_coeff_ + padding_,
+                (max_lat_ - coords.lat) * zoom_coeff_ + padding_};
+        }
+
+        // Проецирует все координаты буфера; результат совпадает с поточечным вызовом operator()
+        void ProjectBatch(const CoordinateBuffer &coordinates, std::vector<svg::Point> &points) const;
+
+        // Проекции совпадают, если совпадают все их параметры: тогда совпадают и координаты всех точек
+        bool operator==(const SphereProjector &other) const
+        {
+            return padding_ == other.padding_ && min_lon_ == other.min_lon_ &&
+                   max_lat_ == other.max_lat_ && zoom_coeff_ == other.zoom_coeff_;
+        }
+
+    private:
+        double padding_;
+        double min_lon_ = 0;
+        double max_lat_ = 0;
+        double zoom_coeff_ = 0;
+
+        void SetBounds(const CoordinateBounds &bounds, double max_width, double max_height)
+        {
+            min_lon_ = bounds.min_lng;
+            const double max_lon = bounds.max_lng;
+            const double min_lat = bounds.min_lat;
+            max_lat_ = bounds.max_lat;
 
             // Вычисляем коэффициент масштабирования вдоль координаты x
             std::optional<double> width_zoom;
             if (!IsZero(max_lon - min_lon_))
             {
-                width_zoom = (max_width - 2 * padding) / (max_lon - min_lon_);
+                width_zoom = (max_width - 2 * padding_) / (max_lon - min_lon_);
             }
 
             // Вычисляем коэффициент масштабирования вдоль координаты y
             std::optional<double> height_zoom;
             if (!IsZero(max_lat_ - min_lat))
             {
-                height_zoom = (max_height - 2 * padding) / (max_lat_ - min_lat);
+                height_zoom = (max_height - 2 * padding_) / (max_lat_ - min_lat);
             }
 
             if (width_zoom && height_zoom)
@@ -83,20 +164,6 @@ namespace renderer
                 zoom_coeff_ = *height_zoom;
             }
         }
-
-        // Проецирует широту и долготу в координаты внутри SVG-изображения
-        svg::Point operator()(geo::Coordinates coords) const
-        {
-            return {
-                (coords.lng - min_lon_) * zoom_coeff_ + padding_,
-                (max_lat_ - coords.lat) * zoom_coeff_ + padding_};
-        }
-
-    private:
-        double padding_;
-        double min_lon_ = 0;
-        double max_lat_ = 0;
-        double zoom_coeff_ = 0;
     };
 
     struct RenderSettings
@@ -113,6 +180,222 @@ namespace renderer
         svg::Color underlayer_color = {svg::NoneColor};
         double underlayer_width = 0.0;
         std::vector<svg::Color> color_palette{};
+        // Необязательные параметры вывода SVG (точность чисел и отступ)
+        svg::RenderOptions svg_options{};
+        // Режим упрощения в пикселях: 0 — выключен; иначе ломаные упрощаются алгоритмом
+        // Дугласа — Пекера с этим допуском, а перекрывающиеся и слишком мелкие подписи пропускаются
+        double lod_tolerance = 0.0;
+        // Компактный SVG: повторяющиеся атрибуты выносятся в классы <style>, а подложка
+        // и текст подписи сливаются в один элемент <text> с paint-order: stroke
+        bool svg_compact = false;
+    };
+
+    // Прямоугольник в координатах полной карты
+    struct Rect
+    {
+        svg::Point min;
+        svg::Point max;
+
+        double Width() const
+        {
+            return max.x - min.x;
+        }
+
+        double Height() const
+        {
+            return max.y - min.y;
+        }
+
+        bool Contains(svg::Point point, double margin = 0.0) const
+        {
+            return point.x >= min.x - margin && point.x <= max.x + margin &&
+                   point.y >= min.y - margin && point.y <= max.y + margin;
+        }
+
+        Rect Expanded(double margin) const
+        {
+            return {{min.x - margin, min.y - margin}, {max.x + margin, max.y + margin}};
+        }
+
+        bool Intersects(const Rect &other) const
+        {
+            return min.x < other.max.x && other.min.x < max.x && min.y < other.max.y && other.min.y < max.y;
+        }
+    };
+
+    // Упрощает ломаную алгоритмом Дугласа — Пекера: оставшиеся точки отстоят от отброшенных
+    // не дальше tolerance. Первая и последняя точки сохраняются всегда
+    std::vector<svg::Point> SimplifyPolyline(const std::vector<svg::Point> &points, double tolerance);
+
+    /*
+     * Жадная расстановка подписей: подпись принимается, если её прямоугольник не пересекается
+     * с уже принятыми. Прямоугольники раскладываются по ячейкам, поэтому проверка не зависит
+     * от общего числа подписей
+     */
+    class LabelPlacer
+    {
+    public:
+        explicit LabelPlacer(double cell_size = 64.0) : cell_size_(cell_size)
+        {
+        }
+
+        bool TryPlace(const Rect &rect);
+
+    private:
+        double cell_size_;
+        std::unordered_map<uint64_t, std::vector<Rect>> cells_;
+
+        template <typename Callback>
+        void ForEachCell(const Rect &rect, Callback callback) const;
+    };
+
+    struct RouteStops;
+
+    /*
+     * Спроецированная карта с пространственным индексом для отрисовки фрагментов.
+     * Точки маршрутов и остановок проецируются один раз так же, как для полной карты,
+     * и раскладываются по равномерной сетке: в ячейке хранятся номера маршрутов, чьи отрезки
+     * задевают ячейку, и номера попавших в неё остановок. Маршруты и остановки лежат
+     * в порядке имён, как на полной карте, поэтому порядок слоёв и цвета совпадают
+     */
+    class MapIndex
+    {
+    public:
+        struct BusEntry
+        {
+            const transport_catalogue::Bus *bus = nullptr;
+            size_t color = 0;
+            // Ломаная маршрута целиком, включая обратный ход некольцевого маршрута
+            std::vector<svg::Point> points;
+            // Точки подписей: начальная остановка и, если отличается, конечная
+            std::vector<svg::Point> labels;
+        };
+
+        struct StopEntry
+        {
+            const transport_catalogue::Stop *stop = nullptr;
+            svg::Point point;
+        };
+
+        MapIndex(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const RenderSettings &settings);
+
+        const std::vector<BusEntry> &GetBuses() const
+        {
+            return buses_;
+        }
+
+        const std::vector<StopEntry> &GetStops() const
+        {
+            return stops_;
+        }
+
+        // Прямоугольник, занимаемый на полной карте областью между заданными широтами и долготами
+        Rect GetBoundingBoxRect(geo::Coordinates min, geo::Coordinates max) const;
+
+        // Номера маршрутов и остановок (по возрастанию) из ячеек сетки, пересекающих rect
+        void Query(const Rect &rect, std::vector<size_t> &buses, std::vector<size_t> &stops) const;
+
+        size_t GetMemoryUsage() const;
+
+    private:
+        MapIndex(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const RenderSettings &settings,
+                 const RouteStops &route_stops);
+
+        SphereProjector projector_;
+        std::vector<BusEntry> buses_;
+        std::vector<StopEntry> stops_;
+
+        Rect bounds_;
+        size_t columns_ = 1;
+        size_t rows_ = 1;
+        double cell_width_ = 1.0;
+        double cell_height_ = 1.0;
+        std::vector<std::vector<size_t>> bus_cells_;
+        std::vector<std::vector<size_t>> stop_cells_;
+
+        size_t Column(double x) const;
+        size_t Row(double y) const;
+    };
+
+    // Участок найденного маршрута: поездка на автобусе bus на span_count перегонов от from до to
+    struct RouteSegment
+    {
+        std::string_view bus;
+        const transport_catalogue::Stop *from = nullptr;
+        const transport_catalogue::Stop *to = nullptr;
+        size_t span_count = 0;
+    };
+
+    /*
+     * Полная карта в виде заранее отрисованных фрагментов SVG: у каждого маршрута спроецированная
+     * ломаная, строка линии и строки подписей, у каждой остановки строки круга и подписи.
+     * При обновлении (MapRenderer::UpdateCache) перерисовываются только маршруты, у которых
+     * изменились остановки или их координаты, тип или цвет, и остановки, у которых изменились координаты или подпись.
+     * Если из-за изменения границ карты сменилась проекция, перерисовывается всё
+     */
+    class MapCache
+    {
+    public:
+        // Собирает документ из фрагментов; результат совпадает с выводом GetDocumentSVG
+        void Render(io::OutputBuffer &out) const;
+
+        // Сколько фрагментов маршрутов и остановок перерисовало последнее обновление
+        size_t GetRebuiltCount() const
+        {
+            return rebuilt_;
+        }
+
+        size_t GetMemoryUsage() const;
+
+        // Спроецированные точки участка маршрута и цвет маршрута на карте
+        struct SegmentPoints
+        {
+            std::vector<svg::Point> points;
+            size_t color = 0;
+        };
+
+        // Ищет участок на ломаной маршрута за время, пропорциональное длине маршрута; nullopt, если участка нет
+        std::optional<SegmentPoints> FindSegment(const RouteSegment &segment) const;
+
+    private:
+        friend class MapRenderer;
+
+        // Подпись (подложка и текст) вместе с оценкой занимаемого ею места для режима упрощения
+        struct LabelFragment
+        {
+            Rect rect;
+            std::string svg;
+        };
+
+        struct BusFragments
+        {
+            std::vector<const transport_catalogue::Stop *> stops;
+            bool is_roundtrip = false;
+            size_t color = 0;
+            std::vector<svg::Point> points;
+            std::string line;
+            std::vector<LabelFragment> labels;
+        };
+
+        struct StopFragments
+        {
+            geo::Coordinates coordinates;
+            bool has_label = false;
+            std::string circle;
+            LabelFragment label;
+        };
+
+        std::optional<SphereProjector> projector_;
+        svg::RenderOptions options_;
+        // Подписи зависят друг от друга, поэтому в режиме упрощения отбираются при сборке
+        double lod_tolerance_ = 0.0;
+        bool compact_ = false;
+        // Элемент <style> компактного режима
+        std::string style_;
+        // Упорядочены по имени, как слои полной карты
+        std::map<std::string, BusFragments, std::less<>> buses_;
+        std::map<std::string, StopFragments, std::less<>> stops_;
+        size_t rebuilt_ = 0;
     };
 
     class MapRenderer
@@ -122,14 +405,87 @@ namespace renderer
         {
         }
 
+        const RenderSettings &GetSettings() const
+        {
+            return render_settings_;
+        }
+
+        const svg::RenderOptions &GetRenderOptions() const
+        {
+            return render_settings_.svg_options;
+        }
+
         svg::Document GetDocumentSVG(const std::map<std::string_view, const transport_catalogue ::Bus *> &buses) const;
 
+        // Выводит полную карту прямо в буфер, не собирая svg::Document: каждый объект выводится
+        // сразу после построения. Результат совпадает с выводом GetDocumentSVG с настройками GetRenderOptions()
+        void RenderMap(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, io::OutputBuffer &out) const;
+
+        // Приводит кэш фрагментов в соответствие с маршрутами, перерисовывая только изменившееся.
+        // С пулом потоков фрагменты перерисовываются параллельно; результат от этого не зависит
+        void UpdateCache(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, MapCache &cache, parallel::ThreadPool *pool = nullptr) const;
+
+        /*
+         * Слой найденного маршрута поверх карты из кэша: участки поездок обводятся подложкой
+         * и рисуются цветом своего маршрута, точки посадки и высадки отмечаются кругами.
+         * Возвращает только объекты слоя, без заголовка документа
+         */
+        svg::Document GetRouteOverlay(const MapCache &cache, const std::vector<RouteSegment> &segments) const;
+
+        // Прямоугольник тайла z/x/y: полная карта делится на 2^z x 2^z равных частей
+        Rect GetTileRect(int zoom, int x, int y) const;
+
+        /*
+         * Отрисовывает часть карты: область viewport растягивается на весь холст с сохранением пропорций.
+         * Кандидаты берутся из индекса, ломаные маршрутов обрезаются по границе области,
+         * толщина линий, радиусы и шрифты не масштабируются
+         */
+        svg::Document GetViewportSVG(const MapIndex &index, const Rect &viewport) const;
+        // То же прямо в буфер, без svg::Document
+        void RenderViewport(const MapIndex &index, const Rect &viewport, io::OutputBuffer &out) const;
+
     private:
         const RenderSettings render_settings_;
 
-        std::vector<svg::Polyline> GetRouteLines(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const SphereProjector &sp) const;
-        std::vector<svg::Text> GetNamesRoute(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const SphereProjector &sp) const;
-        std::vector<svg::Circle> GetStopCircle(const std::map<std::string_view, const transport_catalogue::Stop *> &stops, const SphereProjector &sp) const;
-        std::vector<svg::Text> GetNamesStops(const std::map<std::string_view, const transport_catalogue::Stop *> &stops, const SphereProjector &sp) const;
+        // Число фрагментов в одной задаче пула при параллельном обновлении кэша
+        static constexpr size_t FRAGMENT_CHUNK_SIZE = 64;
+
+        void BuildBusFragments(const transport_catalogue::Bus &bus, size_t color, const SphereProjector &projector, MapCache::BusFragments &fragments) const;
+        void BuildStopFragments(const transport_catalogue::Stop &stop, svg::Point point, MapCache::StopFragments &fragments) const;
+
+        // Классы CSS компактного режима: линии маршрутов, подписи маршрутов и остановок, круги остановок
+        svg::Style MakeStyle() const;
+        svg::Polyline MakeRouteLine(size_t color) const;
+        // Оценка места, занимаемого подписью: ширина символа около 0.6 размера шрифта
+        Rect EstimateLabelRect(svg::Point position, svg::Point offset, int font_size, std::string_view text) const;
+        // Без расстановщика подпись выводится всегда; иначе пропускаются мелкие и перекрывающиеся
+        bool PlaceLabel(LabelPlacer *placer, const Rect &rect, int font_size) const;
+        size_t NextColor(size_t color) const;
+
+        // Объекты добавляются в Container — svg::Document или svg::DocumentWriter, который выводит их сразу.
+        // Шаблоны определены и инстанцируются только в map_renderer.cpp
+        template <typename Container>
+        void AddBusLabel(svg::Point position, const std::string &name, size_t color, Container &result) const;
+        template <typename Container>
+        void AddStopPoint(svg::Point position, Container &result) const;
+        template <typename Container>
+        void AddStopLabel(svg::Point position, const std::string &name, Container &result) const;
+
+        // Объекты слоёв карты добавляются прямо в документ, без промежуточных векторов
+        template <typename Container>
+        void AddRouteLines(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const SphereProjector &sp, Container &result) const;
+        template <typename Container>
+        void AddNamesRoute(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, const SphereProjector &sp, Container &result, LabelPlacer *placer) const;
+        // stop_points — проекции остановок в порядке словаря stops
+        template <typename Container>
+        void AddStopCircle(const std::vector<svg::Point> &stop_points, Container &result) const;
+        template <typename Container>
+        void AddNamesStops(const std::map<std::string_view, const transport_catalogue::Stop *> &stops, const std::vector<svg::Point> &stop_points, Container &result, LabelPlacer *placer) const;
+
+        // Общие части GetDocumentSVG/RenderMap и GetViewportSVG/RenderViewport
+        template <typename Container>
+        void DrawMap(const std::map<std::string_view, const transport_catalogue::Bus *> &buses, Container &result) const;
+        template <typename Container>
+        void DrawViewport(const MapIndex &index, const Rect &viewport, Container &result) const;
     };
 }
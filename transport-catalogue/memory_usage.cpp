@@ -0,0 +1,51 @@
+#include "memory_usage.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <fstream>
+#include <sys/resource.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace memory
+{
+    size_t PeakRssBytes()
+    {
+#if defined(_WIN32)
+        return 0;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#if defined(__APPLE__)
+        // На macOS ru_maxrss задаётся в байтах, в Linux — в килобайтах
+        const auto peak = static_cast<size_t>(usage.ru_maxrss);
+#else
+        const auto peak = static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+        // ru_maxrss обновляется ядром не сразу и может отставать от текущего значения
+        return std::max(peak, CurrentRssBytes());
+#endif
+    }
+
+    size_t CurrentRssBytes()
+    {
+#if defined(__linux__)
+        std::ifstream statm("/proc/self/statm");
+        size_t total_pages = 0;
+        size_t resident_pages = 0;
+        if (!(statm >> total_pages >> resident_pages))
+        {
+            return 0;
+        }
+        return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+}
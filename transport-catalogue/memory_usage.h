@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace memory
+{
+    /*
+     * Оценки занимаемой контейнерами динамической памяти (без размера самого объекта контейнера).
+     * Накладные расходы узлов соответствуют libstdc++: у узла дерева три указателя и цвет,
+     * у узла хеш-таблицы указатель на следующий узел и сохранённый хеш
+     */
+    inline constexpr size_t TREE_NODE_OVERHEAD = 4 * sizeof(void *);
+    inline constexpr size_t HASH_NODE_OVERHEAD = sizeof(void *) + sizeof(size_t);
+    inline constexpr size_t DEQUE_BLOCK_SIZE = 512;
+
+    // Строка занимает кучу, только если не помещается в локальный буфер (SSO)
+    inline size_t StringBytes(const std::string &str)
+    {
+        return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+    }
+
+    template <typename T>
+    size_t VectorBytes(const std::vector<T> &vec)
+    {
+        return vec.capacity() * sizeof(T);
+    }
+
+    template <typename T>
+    size_t DequeBytes(const std::deque<T> &deq)
+    {
+        const size_t per_block = sizeof(T) < DEQUE_BLOCK_SIZE ? DEQUE_BLOCK_SIZE / sizeof(T) : 1;
+        const size_t blocks = deq.size() / per_block + 1;
+        return blocks * per_block * sizeof(T) + (blocks + 2) * sizeof(void *);
+    }
+
+    // std::map и std::set: узлы без учёта памяти, на которую ссылаются сами элементы
+    template <typename Tree>
+    size_t TreeNodesBytes(const Tree &tree)
+    {
+        return tree.size() * (sizeof(typename Tree::value_type) + TREE_NODE_OVERHEAD);
+    }
+
+    // std::unordered_map и std::unordered_set: корзины и узлы
+    template <typename HashTable>
+    size_t HashTableBytes(const HashTable &table)
+    {
+        return table.bucket_count() * sizeof(void *) + table.size() * (sizeof(typename HashTable::value_type) + HASH_NODE_OVERHEAD);
+    }
+
+    // Пиковый и текущий размер резидентной памяти процесса; 0, если платформа не позволяет их узнать
+    size_t PeakRssBytes();
+    size_t CurrentRssBytes();
+}
@@ -0,0 +1,142 @@
+#include "output_buffer.h"
+
+#include <cerrno>
+#include <charconv>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace io
+{
+    OutputBuffer::OutputBuffer(std::ostream &out, size_t flush_threshold)
+        : out_(&out), flush_threshold_(flush_threshold)
+    {
+        buffer_.reserve(flush_threshold_);
+    }
+
+    OutputBuffer::OutputBuffer(int fd, size_t flush_threshold)
+        : fd_(fd), flush_threshold_(flush_threshold)
+    {
+        buffer_.reserve(flush_threshold_);
+    }
+
+    OutputBuffer::OutputBuffer(Sink sink, size_t flush_threshold)
+        : sink_(std::move(sink)), flush_threshold_(flush_threshold)
+    {
+        buffer_.reserve(flush_threshold_);
+    }
+
+    OutputBuffer::~OutputBuffer()
+    {
+        try
+        {
+            Flush();
+        }
+        catch (...)
+        {
+            // Деструктор не должен выпускать исключения наружу
+        }
+    }
+
+    void OutputBuffer::WriteInt(long long value)
+    {
+        char buf[24];
+        const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+        buffer_.append(buf, end);
+        FlushIfFull();
+    }
+
+    void OutputBuffer::WriteDouble(double value)
+    {
+        char buf[32];
+        const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, 6);
+        buffer_.append(buf, end);
+        FlushIfFull();
+    }
+
+    void OutputBuffer::WriteFixed(double value, int precision)
+    {
+        char buf[64];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, precision);
+        if (ec != std::errc{})
+        {
+            // Слишком большое для фиксированной записи число выводим в общем формате
+            WriteDouble(value);
+            return;
+        }
+
+        if (precision > 0)
+        {
+            while (end[-1] == '0')
+            {
+                --end;
+            }
+            if (end[-1] == '.')
+            {
+                --end;
+            }
+        }
+
+        const std::string_view result(buf, end - buf);
+        Write(result == "-0" ? std::string_view("0") : result);
+    }
+
+    void OutputBuffer::Flush()
+    {
+        if (buffer_.empty())
+        {
+            return;
+        }
+
+        if (out_)
+        {
+            out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            out_->flush();
+            buffer_.clear();
+        }
+        else if (fd_ >= 0)
+        {
+            WriteToFd(buffer_.data(), buffer_.size());
+            buffer_.clear();
+        }
+        else if (sink_)
+        {
+            sink_(buffer_);
+            buffer_.clear();
+        }
+    }
+
+    std::string OutputBuffer::Release()
+    {
+        std::string result = std::move(buffer_);
+        buffer_.clear();
+        return result;
+    }
+
+    void OutputBuffer::WriteToFd(const char *data, size_t size) const
+    {
+        while (size > 0)
+        {
+#if defined(_WIN32)
+            const auto written = _write(fd_, data, static_cast<unsigned int>(size));
+#else
+            const auto written = ::write(fd_, data, size);
+#endif
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::runtime_error("failed to write output");
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace io
+{
+    // Дескриптор стандартного вывода (одинаков для POSIX и Windows)
+    inline constexpr int STDOUT_FD = 1;
+
+    /*
+     * Растущий байтовый буфер вывода.
+     * Данные копятся в памяти и сбрасываются в приёмник (файловый дескриптор,
+     * std::ostream или функцию) крупными кусками по достижении порога flush_threshold.
+     * Буфер без приёмника никогда не сбрасывается и служит для сборки строки в памяти
+     */
+    class OutputBuffer
+    {
+    public:
+        static constexpr size_t DEFAULT_FLUSH_THRESHOLD = 1 << 16;
+
+        // Приёмник-функция получает накопленные куски по порядку; например, экранирует их
+        // и дописывает в другой буфер
+        using Sink = std::function<void(std::string_view)>;
+
+        OutputBuffer() = default;
+        explicit OutputBuffer(std::ostream &out, size_t flush_threshold = DEFAULT_FLUSH_THRESHOLD);
+        explicit OutputBuffer(int fd, size_t flush_threshold = DEFAULT_FLUSH_THRESHOLD);
+        explicit OutputBuffer(Sink sink, size_t flush_threshold = DEFAULT_FLUSH_THRESHOLD);
+
+        OutputBuffer(const OutputBuffer &) = delete;
+        OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+        ~OutputBuffer();
+
+        void Put(char c)
+        {
+            buffer_.push_back(c);
+            FlushIfFull();
+        }
+
+        void Write(std::string_view str)
+        {
+            buffer_.append(str.data(), str.size());
+            FlushIfFull();
+        }
+
+        // Целые числа выводятся через std::to_chars
+        void WriteInt(long long value);
+
+        // Вещественные числа выводятся так же, как std::ostream с настройками по умолчанию (%g, 6 значащих цифр)
+        void WriteDouble(double value);
+
+        // Вещественное число с фиксированным числом знаков после точки, хвостовые нули отбрасываются
+        void WriteFixed(double value, int precision);
+
+        // Сбрасывает накопленные данные в приёмник; без приёмника ничего не делает
+        void Flush();
+
+        std::string_view View() const
+        {
+            return buffer_;
+        }
+
+        size_t Size() const
+        {
+            return buffer_.size();
+        }
+
+        void Reserve(size_t capacity)
+        {
+            buffer_.reserve(capacity);
+        }
+
+        void Clear()
+        {
+            buffer_.clear();
+        }
+
+        // Забирает накопленную строку, оставляя буфер пустым
+        std::string Release();
+
+    private:
+        std::string buffer_;
+        std::ostream *out_ = nullptr;
+        int fd_ = -1;
+        Sink sink_;
+        size_t flush_threshold_ = DEFAULT_FLUSH_THRESHOLD;
+
+        void FlushIfFull()
+        {
+            if (buffer_.size() >= flush_threshold_ && (out_ || fd_ >= 0 || sink_))
+            {
+                Flush();
+            }
+        }
+
+        void WriteToFd(const char *data, size_t size) const;
+    };
+}
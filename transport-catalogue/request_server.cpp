@@ -0,0 +1,221 @@
+#include "request_server.h"
+
+#include "json_stream_builder.h"
+
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace server
+{
+    namespace
+    {
+        void PrintError(std::string_view message, const json::Node *id, io::OutputBuffer &output)
+        {
+            json::StreamBuilder builder(output);
+            auto dict = builder.StartDict().Key("error_message").Value(message);
+            if (id && id->IsInt())
+            {
+                dict.Key("request_id").Value(id->AsInt());
+            }
+            dict.EndDict();
+        }
+    }
+
+    void RequestServer::ServeStream(std::istream &input, io::OutputBuffer &output) const
+    {
+        std::string line;
+        while (std::getline(input, line))
+        {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+            AnswerLine(line, output);
+            output.Flush();
+        }
+    }
+
+    void RequestServer::AnswerLine(std::string_view line, io::OutputBuffer &output) const
+    {
+        // Ответ собирается отдельно, чтобы при ошибке в середине запроса не вывести его часть;
+        // буфер у каждого потока свой и переиспользуется между запросами
+        thread_local io::OutputBuffer response;
+        response.Clear();
+
+        try
+        {
+            const json::Document request = json::LoadView(std::string(line));
+            if (!request.GetRoot().IsMap())
+            {
+                PrintError("request must be a JSON object", nullptr, response);
+            }
+            else
+            {
+                const json::Dict &request_map = request.GetRoot().AsMap();
+                const json::Node *id = request_map.count("id") ? &request_map.at("id") : nullptr;
+                try
+                {
+                    reader_.PrintResponse(request_map, catalogue_, router_, response);
+                    if (response.Size() == 0)
+                    {
+                        PrintError("unknown request type", id, response);
+                    }
+                }
+                catch (const std::exception &)
+                {
+                    response.Clear();
+                    PrintError("invalid request", id, response);
+                }
+            }
+        }
+        catch (const json::ParsingError &)
+        {
+            response.Clear();
+            PrintError("invalid JSON", nullptr, response);
+        }
+
+        output.Write(response.View());
+        output.Put('\n');
+    }
+
+#if !defined(_WIN32)
+    void RequestServer::ServeUnixSocket(const std::string &path) const
+    {
+        // Клиент может закрыть соединение до получения ответа, это не должно завершать сервис
+        std::signal(SIGPIPE, SIG_IGN);
+
+        const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0)
+        {
+            throw std::runtime_error("failed to create socket");
+        }
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            ::close(listen_fd);
+            throw std::invalid_argument("socket path is too long");
+        }
+        path.copy(address.sun_path, path.size());
+        ::unlink(path.c_str());
+
+        if (::bind(listen_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 || ::listen(listen_fd, SOMAXCONN) < 0)
+        {
+            ::close(listen_fd);
+            throw std::runtime_error("failed to listen on " + path);
+        }
+
+        while (true)
+        {
+            {
+                std::unique_lock lock(connections_mutex_);
+                connections_cv_.wait(lock, [this]
+                                     { return active_connections_ < MAX_CONNECTIONS; });
+            }
+
+            const int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                ::close(listen_fd);
+                throw std::runtime_error("failed to accept connection");
+            }
+
+            {
+                std::lock_guard lock(connections_mutex_);
+                ++active_connections_;
+            }
+            try
+            {
+                std::thread([this, fd]
+                            {
+                    ServeConnection(fd);
+                    std::lock_guard lock(connections_mutex_);
+                    --active_connections_;
+                    connections_cv_.notify_one(); })
+                    .detach();
+            }
+            catch (const std::system_error &)
+            {
+                // Поток не создан: подключение закрывается, сервис продолжает работу
+                ::close(fd);
+                std::lock_guard lock(connections_mutex_);
+                --active_connections_;
+            }
+        }
+    }
+
+    void RequestServer::ServeConnection(int fd) const
+    {
+        try
+        {
+            io::OutputBuffer output(fd);
+            std::string pending;
+            char chunk[1 << 16];
+
+            while (true)
+            {
+                const auto received = ::read(fd, chunk, sizeof(chunk));
+                if (received < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (received <= 0)
+                {
+                    break;
+                }
+                pending.append(chunk, static_cast<size_t>(received));
+
+                // Отвечаем на все полностью полученные строки и сбрасываем ответы одной записью
+                size_t line_start = 0;
+                for (size_t line_end = pending.find('\n'); line_end != std::string::npos; line_end = pending.find('\n', line_start))
+                {
+                    const std::string_view line = std::string_view(pending).substr(line_start, line_end - line_start);
+                    if (line.find_first_not_of(" \t\r") != std::string_view::npos)
+                    {
+                        AnswerLine(line, output);
+                    }
+                    line_start = line_end + 1;
+                }
+                pending.erase(0, line_start);
+
+                if (pending.size() > MAX_LINE_SIZE)
+                {
+                    PrintError("request line is too long", nullptr, output);
+                    output.Put('\n');
+                    output.Flush();
+                    break;
+                }
+                output.Flush();
+            }
+        }
+        catch (const std::exception &)
+        {
+            // Ошибка записи означает, что клиент отключился
+        }
+        ::close(fd);
+    }
+#else
+    void RequestServer::ServeUnixSocket(const std::string &) const
+    {
+        throw std::logic_error("Unix domain sockets are not supported on this platform");
+    }
+
+    void RequestServer::ServeConnection(int) const
+    {
+    }
+#endif
+}
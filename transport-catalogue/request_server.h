@@ -0,0 +1,53 @@
+#pragma once
+
+#include "json_reader.h"
+#include "output_buffer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace server
+{
+    /*
+     * Режим долгоживущего сервиса: каталог и маршрутизатор строятся один раз,
+     * после чего сервер отвечает на запросы в формате JSON Lines —
+     * одна строка с запросом (как элемент stat_requests), одна строка с ответом
+     */
+    class RequestServer
+    {
+    public:
+        RequestServer(const JsonReader &reader, const transport_catalogue::TransportCatalogue &catalogue, const transport_catalogue::Router &router)
+            : reader_(reader), catalogue_(catalogue), router_(router)
+        {
+        }
+
+        // Читает запросы из потока до его окончания, ответ на каждую строку сбрасывается сразу
+        void ServeStream(std::istream &input, io::OutputBuffer &output) const;
+
+        // Принимает подключения на Unix domain socket; каждое подключение обслуживается своим потоком,
+        // одновременно обслуживается не больше MAX_CONNECTIONS подключений, остальные ждут в очереди сокета
+        void ServeUnixSocket(const std::string &path) const;
+
+        static constexpr size_t MAX_CONNECTIONS = 64;
+        // Подключение, приславшее строку длиннее без перевода строки, получает ошибку и закрывается
+        static constexpr size_t MAX_LINE_SIZE = 1 << 20;
+
+    private:
+        const JsonReader &reader_;
+        const transport_catalogue::TransportCatalogue &catalogue_;
+        const transport_catalogue::Router &router_;
+
+        mutable std::mutex connections_mutex_;
+        mutable std::condition_variable connections_cv_;
+        mutable size_t active_connections_ = 0;
+
+        // Отвечает на одну строку запроса; ошибки разбора превращаются в ответ с error_message
+        void AnswerLine(std::string_view line, io::OutputBuffer &output) const;
+        void ServeConnection(int fd) const;
+    };
+}
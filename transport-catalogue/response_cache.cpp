@@ -0,0 +1,99 @@
+#include "response_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace cache
+{
+    std::optional<CachedResponse> CachedResponse::Split(std::string_view body, std::string_view id_key)
+    {
+        std::string pattern;
+        pattern.reserve(id_key.size() + 3);
+        pattern.push_back('"');
+        pattern.append(id_key);
+        pattern.append("\":");
+
+        const size_t key_pos = body.find(pattern);
+        if (key_pos == std::string_view::npos)
+        {
+            return std::nullopt;
+        }
+
+        const size_t value_begin = key_pos + pattern.size();
+        size_t value_end = value_begin;
+        if (value_end < body.size() && body[value_end] == '-')
+        {
+            ++value_end;
+        }
+        while (value_end < body.size() && body[value_end] >= '0' && body[value_end] <= '9')
+        {
+            ++value_end;
+        }
+
+        return CachedResponse{std::string(body.substr(0, value_begin)), std::string(body.substr(value_end))};
+    }
+
+    ResponseCache::ResponseCache(size_t capacity, size_t shard_count)
+        : shard_capacity_(std::max<size_t>(1, capacity / std::max<size_t>(1, shard_count)))
+    {
+        shard_count = std::max<size_t>(1, shard_count);
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i)
+        {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    std::shared_ptr<const CachedResponse> ResponseCache::Find(const std::string &key)
+    {
+        Shard &shard = GetShard(key);
+        std::lock_guard lock(shard.mutex);
+
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end())
+        {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return it->second->response;
+    }
+
+    void ResponseCache::Insert(std::string key, std::shared_ptr<const CachedResponse> response)
+    {
+        Shard &shard = GetShard(key);
+        std::lock_guard lock(shard.mutex);
+
+        if (const auto it = shard.index.find(key); it != shard.index.end())
+        {
+            // Ответ мог быть вычислен параллельно в другом потоке
+            it->second->response = std::move(response);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+
+        shard.entries.push_front(Entry{std::move(key), std::move(response)});
+        shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+
+        if (shard.entries.size() > shard_capacity_)
+        {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ResponseCache::Stats ResponseCache::GetStats() const
+    {
+        return {hits_.load(std::memory_order_relaxed),
+                misses_.load(std::memory_order_relaxed),
+                evictions_.load(std::memory_order_relaxed)};
+    }
+
+    ResponseCache::Shard &ResponseCache::GetShard(std::string_view key)
+    {
+        return *shards_[std::hash<std::string_view>{}(key) % shards_.size()];
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cache
+{
+    /*
+     * Сериализованный ответ без значения request_id: ответ собирается как head + id + tail
+     */
+    struct CachedResponse
+    {
+        std::string head;
+        std::string tail;
+
+        // Делит готовый ответ вокруг значения ключа верхнего уровня id_key.
+        // Кавычки внутри строковых значений экранированы, поэтому "id_key": встречается только как ключ
+        static std::optional<CachedResponse> Split(std::string_view body, std::string_view id_key);
+    };
+
+    /*
+     * Ограниченный LRU-кэш ответов, разбитый на шарды с отдельными мьютексами,
+     * чтобы параллельные запросы не конкурировали за одну блокировку
+     */
+    class ResponseCache
+    {
+    public:
+        struct Stats
+        {
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t evictions = 0;
+        };
+
+        explicit ResponseCache(size_t capacity, size_t shard_count = 16);
+
+        std::shared_ptr<const CachedResponse> Find(const std::string &key);
+        void Insert(std::string key, std::shared_ptr<const CachedResponse> response);
+
+        Stats GetStats() const;
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            std::shared_ptr<const CachedResponse> response;
+        };
+
+        struct Shard
+        {
+            std::mutex mutex;
+            std::list<Entry> entries; // в начале — последние использованные
+            std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards_;
+        size_t shard_capacity_;
+        std::atomic<size_t> hits_{0};
+        std::atomic<size_t> misses_{0};
+        std::atomic<size_t> evictions_{0};
+
+        Shard &GetShard(std::string_view key);
+    };
+}
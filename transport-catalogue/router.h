@@ -1,6 +1,7 @@
 #pragma once
 
 #include "graph.h"
+#include "memory_usage.h"
 
 #include <algorithm>
 #include <cassert>
@@ -32,6 +33,17 @@ namespace graph
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+        // Оценка памяти таблицы предрасчёта маршрутов (граф не учитывается)
+        size_t GetMemoryUsage() const
+        {
+            size_t result = sizeof(Router) + memory::VectorBytes(routes_internal_data_);
+            for (const auto &routes : routes_internal_data_)
+            {
+                result += memory::VectorBytes(routes);
+            }
+            return result;
+        }
+
     private:
         struct RouteInternalData
         {
@@ -0,0 +1,118 @@
+#include "run_stats.h"
+
+#include "json_stream_builder.h"
+
+#include <algorithm>
+
+namespace stats
+{
+    void RunStats::AddPhase(std::string_view name, long long ns)
+    {
+        std::lock_guard lock(mutex_);
+        phases_.emplace_back(name, ns);
+    }
+
+    namespace
+    {
+        void SetValue(std::vector<std::pair<std::string, long long>> &values, std::string_view name, long long value)
+        {
+            const auto it = std::find_if(values.begin(), values.end(), [name](const auto &item)
+                                         { return item.first == name; });
+            if (it != values.end())
+            {
+                it->second = value;
+            }
+            else
+            {
+                values.emplace_back(name, value);
+            }
+        }
+    }
+
+    void RunStats::SetCounter(std::string_view name, long long value)
+    {
+        std::lock_guard lock(mutex_);
+        SetValue(counters_, name, value);
+    }
+
+    void RunStats::SetMemory(std::string_view subsystem, long long bytes)
+    {
+        std::lock_guard lock(mutex_);
+        SetValue(memory_, subsystem, bytes);
+    }
+
+    void RunStats::UpdateMemoryPeak(std::string_view subsystem, long long bytes)
+    {
+        std::lock_guard lock(mutex_);
+        const auto it = std::find_if(memory_.begin(), memory_.end(), [subsystem](const auto &item)
+                                     { return item.first == subsystem; });
+        if (it == memory_.end())
+        {
+            memory_.emplace_back(subsystem, bytes);
+        }
+        else
+        {
+            it->second = std::max(it->second, bytes);
+        }
+    }
+
+    void RunStats::AddRequest(std::string_view type, long long ns)
+    {
+        const size_t index = std::find(REQUEST_TYPES.begin(), REQUEST_TYPES.end() - 1, type) - REQUEST_TYPES.begin();
+        RequestCounters &counters = requests_[index];
+
+        counters.count.fetch_add(1, std::memory_order_relaxed);
+        counters.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        long long max_ns = counters.max_ns.load(std::memory_order_relaxed);
+        while (ns > max_ns && !counters.max_ns.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void RunStats::Print(io::OutputBuffer &output) const
+    {
+        std::lock_guard lock(mutex_);
+        json::StreamBuilder builder(output);
+        auto root = builder.StartDict();
+
+        auto phases = root.Key("phases").StartArray();
+        for (const auto &[name, ns] : phases_)
+        {
+            phases.StartDict().Key("name").Value(name).Key("ns").Value(ns).EndDict();
+        }
+        phases.EndArray();
+
+        auto counters = root.Key("counters").StartDict();
+        for (const auto &[name, value] : counters_)
+        {
+            counters.Key(name).Value(value);
+        }
+        counters.EndDict();
+
+        auto memory = root.Key("memory_bytes").StartDict();
+        for (const auto &[subsystem, bytes] : memory_)
+        {
+            memory.Key(subsystem).Value(bytes);
+        }
+        memory.EndDict();
+
+        auto requests = root.Key("requests").StartDict();
+        for (size_t i = 0; i < REQUEST_TYPES.size(); ++i)
+        {
+            const long long count = requests_[i].count.load(std::memory_order_relaxed);
+            if (count == 0)
+            {
+                continue;
+            }
+            requests.Key(REQUEST_TYPES[i])
+                .StartDict()
+                .Key("count").Value(count)
+                .Key("total_ns").Value(requests_[i].total_ns.load(std::memory_order_relaxed))
+                .Key("max_ns").Value(requests_[i].max_ns.load(std::memory_order_relaxed))
+                .EndDict();
+        }
+        requests.EndDict();
+
+        root.EndDict().Finish();
+    }
+}
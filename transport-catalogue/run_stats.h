@@ -0,0 +1,90 @@
+#pragma once
+
+#include "output_buffer.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace stats
+{
+    using Clock = std::chrono::steady_clock;
+
+    inline long long ElapsedNs(Clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    /*
+     * Отчёт о прогоне: время этапов (разбор JSON, заполнение справочника, построение графа,
+     * предрасчёт маршрутов, ...), счётчики, память подсистем и статистика запросов по типам.
+     * Этапы и счётчики редки и пишутся под мьютексом, запросы учитываются атомарными счётчиками
+     * и могут приходить из нескольких потоков одновременно
+     */
+    class RunStats
+    {
+    public:
+        void AddPhase(std::string_view name, long long ns);
+        void SetCounter(std::string_view name, long long value);
+        void AddRequest(std::string_view type, long long ns);
+        // Оценка памяти подсистемы в байтах; повторная запись заменяет значение
+        void SetMemory(std::string_view subsystem, long long bytes);
+        // Оценка памяти объекта, который создаётся на каждый запрос: в отчёте остаётся наибольшая
+        void UpdateMemoryPeak(std::string_view subsystem, long long bytes);
+
+        // Выводит отчёт одним JSON-документом
+        void Print(io::OutputBuffer &output) const;
+
+    private:
+        struct RequestCounters
+        {
+            std::atomic<long long> count{0};
+            std::atomic<long long> total_ns{0};
+            std::atomic<long long> max_ns{0};
+        };
+
+        // Последний элемент учитывает запросы неизвестных типов
+        static constexpr std::array<std::string_view, 6> REQUEST_TYPES = {"Bus", "Map", "Route", "RouteMap", "Stop", "other"};
+
+        mutable std::mutex mutex_;
+        std::vector<std::pair<std::string, long long>> phases_;
+        std::vector<std::pair<std::string, long long>> counters_;
+        std::vector<std::pair<std::string, long long>> memory_;
+        std::array<RequestCounters, REQUEST_TYPES.size()> requests_;
+    };
+
+    // Замеряет время жизни объекта как этап отчёта; без отчёта ничего не делает
+    class PhaseTimer
+    {
+    public:
+        PhaseTimer(RunStats *stats, std::string_view name)
+            : stats_(stats), name_(name)
+        {
+            if (stats_)
+            {
+                start_ = Clock::now();
+            }
+        }
+
+        PhaseTimer(const PhaseTimer &) = delete;
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+        ~PhaseTimer()
+        {
+            if (stats_)
+            {
+                stats_->AddPhase(name_, ElapsedNs(start_));
+            }
+        }
+
+    private:
+        RunStats *stats_;
+        std::string_view name_;
+        Clock::time_point start_;
+    };
+}
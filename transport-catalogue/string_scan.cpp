@@ -0,0 +1,110 @@
+#include "string_scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JSON_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace json
+{
+    namespace
+    {
+        inline bool IsSpecialChar(char c)
+        {
+            return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+        }
+
+#ifdef JSON_SCAN_X86
+        inline unsigned CountTrailingZeros(unsigned mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
+#else
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
+
+        size_t FindSpecialCharSse2(std::string_view str, size_t pos)
+        {
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i control_max = _mm_set1_epi8(0x1F);
+
+            for (; pos + 16 <= str.size(); pos += 16)
+            {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str.data() + pos));
+                // Беззнаковое сравнение chunk <= 0x1F: min(chunk, 0x1F) == chunk
+                const __m128i is_control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, control_max), chunk);
+                const __m128i is_special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), is_control);
+                if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(is_special)))
+                {
+                    return pos + CountTrailingZeros(mask);
+                }
+            }
+
+            return FindSpecialCharScalar(str, pos);
+        }
+
+#if defined(__GNUC__) || defined(__clang__)
+#define JSON_SCAN_AVX2 1
+        __attribute__((target("avx2"))) size_t FindSpecialCharAvx2(std::string_view str, size_t pos)
+        {
+            const __m256i quote = _mm256_set1_epi8('"');
+            const __m256i backslash = _mm256_set1_epi8('\\');
+            const __m256i control_max = _mm256_set1_epi8(0x1F);
+
+            for (; pos + 32 <= str.size(); pos += 32)
+            {
+                const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(str.data() + pos));
+                const __m256i is_control = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control_max), chunk);
+                const __m256i is_special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)), is_control);
+                if (const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(is_special)))
+                {
+                    return pos + CountTrailingZeros(mask);
+                }
+            }
+
+            return FindSpecialCharSse2(str, pos);
+        }
+#endif
+
+        using ScanFunction = size_t (*)(std::string_view, size_t);
+
+        ScanFunction SelectScanFunction()
+        {
+#ifdef JSON_SCAN_AVX2
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return FindSpecialCharAvx2;
+            }
+#endif
+            return FindSpecialCharSse2;
+        }
+#endif
+    }
+
+    size_t FindSpecialCharScalar(std::string_view str, size_t pos)
+    {
+        for (; pos < str.size(); ++pos)
+        {
+            if (IsSpecialChar(str[pos]))
+            {
+                return pos;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    size_t FindSpecialChar(std::string_view str, size_t pos)
+    {
+#ifdef JSON_SCAN_X86
+        static const ScanFunction scan = SelectScanFunction();
+        return scan(str, pos);
+#else
+        return FindSpecialCharScalar(str, pos);
+#endif
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace json
+{
+    /*
+     * Ищет в строке, начиная с позиции pos, первый символ, требующий особой обработки
+     * при разборе или выводе JSON: кавычку, обратную косую черту или управляющий байт (< 0x20).
+     * Возвращает его позицию или std::string_view::npos.
+     * На x86-64 строка просматривается блоками по 16 (SSE2) или 32 (AVX2) байта,
+     * подходящая реализация выбирается во время выполнения; на прочих платформах — скалярный цикл
+     */
+    size_t FindSpecialChar(std::string_view str, size_t pos = 0);
+
+    // Скалярная реализация, используется для хвостов блоков и в проверках
+    size_t FindSpecialCharScalar(std::string_view str, size_t pos = 0);
+}
@@ -1,48 +1,56 @@
 #include "svg.h"
 
+#include <sstream>
+
 namespace svg
 {
 
     using namespace std::literals;
 
-    std::ostream &operator<<(std::ostream &out, StrokeLineCap line_cap)
+    // Буфер, через который объект выводится в ostream: объект обычно невелик,
+    // поэтому большой буфер по умолчанию не резервируется
+    static constexpr size_t STREAM_CHUNK_SIZE = 1 << 10;
+
+    std::string_view ToString(StrokeLineCap line_cap)
     {
         switch (line_cap)
         {
         case StrokeLineCap::BUTT:
-            out << "butt"sv;
-            break;
+            return "butt"sv;
         case StrokeLineCap::ROUND:
-            out << "round"sv;
-            break;
+            return "round"sv;
         case StrokeLineCap::SQUARE:
-            out << "square"sv;
-            break;
+            return "square"sv;
         }
-        return out;
+        return {};
     }
 
-    std::ostream &operator<<(std::ostream &out, StrokeLineJoin line_join)
+    std::string_view ToString(StrokeLineJoin line_join)
     {
         switch (line_join)
         {
         case StrokeLineJoin::ARCS:
-            out << "arcs"sv;
-            break;
+            return "arcs"sv;
         case StrokeLineJoin::BEVEL:
-            out << "bevel"sv;
-            break;
+            return "bevel"sv;
         case StrokeLineJoin::MITER:
-            out << "miter"sv;
-            break;
+            return "miter"sv;
         case StrokeLineJoin::MITER_CLIP:
-            out << "miter-clip"sv;
-            break;
+            return "miter-clip"sv;
         case StrokeLineJoin::ROUND:
-            out << "round"sv;
-            break;
+            return "round"sv;
         }
-        return out;
+        return {};
+    }
+
+    std::ostream &operator<<(std::ostream &out, StrokeLineCap line_cap)
+    {
+        return out << ToString(line_cap);
+    }
+
+    std::ostream &operator<<(std::ostream &out, StrokeLineJoin line_join)
+    {
+        return out << ToString(line_join);
     }
 
     std::ostream &operator<<(std::ostream &out, Color &color)
@@ -51,31 +59,73 @@ namespace svg
         return out;
     }
 
-    void HtmlEncodeString(std::ostream &out, std::string_view sv)
+    void RenderColor(const Color &color, const BufferContext &context)
+    {
+        auto &out = context.out;
+        if (std::holds_alternative<std::monostate>(color))
+        {
+            out.Write("none"sv);
+        }
+        else if (const auto *name = std::get_if<std::string>(&color))
+        {
+            out.Write(*name);
+        }
+        else if (const auto *rgb = std::get_if<Rgb>(&color))
+        {
+            out.Write("rgb("sv);
+            out.WriteInt(rgb->red);
+            out.Put(',');
+            out.WriteInt(rgb->green);
+            out.Put(',');
+            out.WriteInt(rgb->blue);
+            out.Put(')');
+        }
+        else if (const auto *rgba = std::get_if<Rgba>(&color))
+        {
+            out.Write("rgba("sv);
+            out.WriteInt(rgba->red);
+            out.Put(',');
+            out.WriteInt(rgba->green);
+            out.Put(',');
+            out.WriteInt(rgba->blue);
+            out.Put(',');
+            context.WriteNumber(rgba->opacity);
+            out.Put(')');
+        }
+    }
+
+    void HtmlEncodeString(io::OutputBuffer &out, std::string_view sv)
     {
-        for (char c : sv)
+        // Текст без спецсимволов копируется кусками между ними
+        size_t start = 0;
+        for (size_t i = 0; i < sv.size(); ++i)
         {
-            switch (c)
+            std::string_view replacement;
+            switch (sv[i])
             {
             case '"':
-                out << "&quot;"sv;
+                replacement = "&quot;"sv;
                 break;
             case '<':
-                out << "&lt;"sv;
+                replacement = "&lt;"sv;
                 break;
             case '>':
-                out << "&gt;"sv;
+                replacement = "&gt;"sv;
                 break;
             case '&':
-                out << "&amp;"sv;
+                replacement = "&amp;"sv;
                 break;
             case '\'':
-                out << "&apos;"sv;
+                replacement = "&apos;"sv;
                 break;
             default:
-                out.put(c);
+                continue;
             }
+            out.Write(sv.substr(start, i - start));
+            out.Write(replacement);
+            start = i + 1;
         }
+        out.Write(sv.substr(start));
     }
 
     void Object::Render(const RenderContext &context) const
@@ -85,7 +135,7 @@ namespace svg
         // Делегируем вывод тега своим подклассам
         RenderObject(context);
 
-        context.out << std::endl;
+        context.out.put('\n');
     }
 
     // ---------- Circle ------------------
@@ -102,13 +152,31 @@ namespace svg
         return *this;
     }
 
+    size_t Circle::GetMemoryUsage() const
+    {
+        return sizeof(Circle) + GetAttrsMemoryUsage();
+    }
+
     void Circle::RenderObject(const RenderContext &context) const
+    {
+        // Вывод реализован один раз, в буфер; поток получает тот же текст
+        io::OutputBuffer buffer(context.out, STREAM_CHUNK_SIZE);
+        RenderObject(BufferContext(buffer, {}));
+        buffer.Flush();
+    }
+
+    void Circle::RenderObject(const BufferContext &context) const
     {
         auto &out = context.out;
-        out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-        out << "r=\""sv << radius_ << "\" "sv;
-        RenderAttrs(out);
-        out << "/>"sv;
+        out.Write("<circle cx=\""sv);
+        context.WriteNumber(center_.x);
+        out.Write("\" cy=\""sv);
+        context.WriteNumber(center_.y);
+        out.Write("\" r=\""sv);
+        context.WriteNumber(radius_);
+        out.Write("\" "sv);
+        RenderAttrs(context);
+        out.Write("/>"sv);
     }
 
     // ---------- Polyline ------------------
@@ -119,26 +187,43 @@ namespace svg
         return *this;
     }
 
+    Polyline &Polyline::ReservePoints(size_t count)
+    {
+        points_.reserve(count);
+        return *this;
+    }
+
+    size_t Polyline::GetMemoryUsage() const
+    {
+        return sizeof(Polyline) + GetAttrsMemoryUsage() + memory::VectorBytes(points_);
+    }
+
     void Polyline::RenderObject(const RenderContext &context) const
+    {
+        io::OutputBuffer buffer(context.out, STREAM_CHUNK_SIZE);
+        RenderObject(BufferContext(buffer, {}));
+        buffer.Flush();
+    }
+
+    void Polyline::RenderObject(const BufferContext &context) const
     {
         auto &out = context.out;
+        out.Write("<polyline points=\""sv);
         bool is_first = true;
-        out << "<polyline points=\""sv;
         for (const auto &point : points_)
         {
-            if (is_first)
+            if (!is_first)
             {
-                out << point.x << "," << point.y;
-                is_first = false;
-            }
-            else
-            {
-                out << " " << point.x << "," << point.y;
+                out.Put(' ');
             }
+            is_first = false;
+            context.WriteNumber(point.x);
+            out.Put(',');
+            context.WriteNumber(point.y);
         }
-        out << "\""sv;
-        RenderAttrs(out);
-        out << "/>"sv;
+        out.Put('"');
+        RenderAttrs(context);
+        out.Write("/>"sv);
     }
 
     // ---------- Text ------------------
@@ -158,7 +243,7 @@ namespace svg
     }
 
     // Задаёт размеры шрифта (атрибут font-size)
-    Text &Text::SetFontSize(uint32_t size)
+    Text &Text::SetFontSize(std::optional<uint32_t> size)
     {
         size_ = size;
         return *this;
@@ -185,22 +270,88 @@ namespace svg
         return *this;
     }
 
+    size_t Text::GetMemoryUsage() const
+    {
+        return sizeof(Text) + GetAttrsMemoryUsage() + memory::StringBytes(font_family_) + memory::StringBytes(font_weight_) + memory::StringBytes(data_);
+    }
+
     void Text::RenderObject(const RenderContext &context) const
+    {
+        io::OutputBuffer buffer(context.out, STREAM_CHUNK_SIZE);
+        RenderObject(BufferContext(buffer, {}));
+        buffer.Flush();
+    }
+
+    void Text::RenderObject(const BufferContext &context) const
     {
         auto &out = context.out;
-        out << "<text"sv;
-        RenderAttrs(out);
-        out << " x=\""sv << pos_.x << "\" y=\""sv << pos_.y << "\" "sv;
-        out << "dx=\""sv << offset_.x << "\" dy=\""sv << offset_.y << "\" "sv;
-        out << "font-size=\""sv << size_ << "\""sv;
+        out.Write("<text"sv);
+        RenderAttrs(context);
+        out.Write(" x=\""sv);
+        context.WriteNumber(pos_.x);
+        out.Write("\" y=\""sv);
+        context.WriteNumber(pos_.y);
+        out.Write("\" dx=\""sv);
+        context.WriteNumber(offset_.x);
+        out.Write("\" dy=\""sv);
+        context.WriteNumber(offset_.y);
+        out.Put('"');
+        if (size_)
+        {
+            out.Write(" font-size=\""sv);
+            out.WriteInt(*size_);
+            out.Put('"');
+        }
         if (!font_family_.empty())
-            out << " font-family=\""sv << font_family_ << "\""sv;
+        {
+            out.Write(" font-family=\""sv);
+            out.Write(font_family_);
+            out.Put('"');
+        }
         if (!font_weight_.empty())
-            out << " font-weight=\""sv << font_weight_ << "\""sv;
-        out << ">"sv;
+        {
+            out.Write(" font-weight=\""sv);
+            out.Write(font_weight_);
+            out.Put('"');
+        }
+        out.Put('>');
         HtmlEncodeString(out, data_);
+        out.Write("</text>"sv);
+    }
+
+    // ---------- Style ------------------
 
-        out << "</text>"sv;
+    size_t Style::GetMemoryUsage() const
+    {
+        return sizeof(Style) + memory::StringBytes(rules_);
+    }
+
+    void Style::RenderObject(const RenderContext &context) const
+    {
+        io::OutputBuffer buffer(context.out, STREAM_CHUNK_SIZE);
+        RenderObject(BufferContext(buffer, {}));
+        buffer.Flush();
+    }
+
+    void Style::RenderObject(const BufferContext &context) const
+    {
+        auto &out = context.out;
+        out.Write("<style>"sv);
+        HtmlEncodeString(out, rules_);
+        out.Write("</style>"sv);
+    }
+
+    namespace
+    {
+        // Сторонние наследники Object умеют выводиться только в ostream
+        void RenderForeignObject(const Object &object, const BufferContext &context)
+        {
+            std::ostringstream object_out;
+            object.Render(RenderContext(object_out));
+            std::string rendered = object_out.str();
+            rendered.pop_back();
+            context.out.Write(rendered);
+        }
     }
 
     // ---------- Doc ------------------
@@ -211,16 +362,97 @@ namespace svg
         objects_.emplace_back(std::move(obj));
     }
 
+    void Document::Reserve(size_t count)
+    {
+        objects_.reserve(count);
+    }
+
+    size_t Document::GetMemoryUsage() const
+    {
+        size_t result = sizeof(Document) + memory::VectorBytes(objects_);
+        for (const auto &stored : objects_)
+        {
+            result += std::visit([](const auto &object)
+                                 {
+                using T = std::decay_t<decltype(object)>;
+                if constexpr (std::is_same_v<T, std::unique_ptr<Object>>)
+                {
+                    return object->GetMemoryUsage();
+                }
+                else
+                {
+                    // Сам объект уже учтён в размере массива
+                    return object.GetMemoryUsage() - sizeof(T);
+                } }, stored);
+        }
+        return result;
+    }
+
     // Выводит в ostream svg-представление документа
     void Document::Render(std::ostream &out) const
     {
-        RenderContext out_str(out, 2, 2);
-        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
-        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
-        for (const auto &obj : objects_)
+        io::OutputBuffer buffer(out);
+        Render(buffer);
+        buffer.Flush();
+    }
+
+    void Document::Render(io::OutputBuffer &out, const RenderOptions &options) const
+    {
+        RenderBegin(out);
+        RenderObjects(out, options);
+        RenderEnd(out);
+    }
+
+    void Document::RenderBegin(io::OutputBuffer &out)
+    {
+        out.Write("<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv);
+        out.Write("<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv);
+    }
+
+    void Document::RenderEnd(io::OutputBuffer &out)
+    {
+        out.Write("</svg>\n"sv);
+    }
+
+    void Document::RenderObjects(io::OutputBuffer &out, const RenderOptions &options) const
+    {
+        const BufferContext context(out, options);
+        for (const auto &stored : objects_)
         {
-            obj->Render(out_str);
+            context.RenderIndent();
+            std::visit([&context](const auto &object)
+                       {
+                using T = std::decay_t<decltype(object)>;
+                if constexpr (std::is_same_v<T, std::unique_ptr<Object>>)
+                {
+                    RenderForeignObject(*object, context);
+                }
+                else
+                {
+                    // Тип известен статически и объявлен final, поэтому вызов не виртуальный
+                    object.RenderObject(context);
+                } }, stored);
+            out.Put('\n');
         }
-        out << "</svg>\n";
+    }
+
+    // ---------- DocumentWriter ------------------
+
+    DocumentWriter::DocumentWriter(io::OutputBuffer &out, const RenderOptions &options)
+        : options_(options), context_(out, options_)
+    {
+        Document::RenderBegin(out);
+    }
+
+    void DocumentWriter::AddPtr(std::unique_ptr<Object> &&obj)
+    {
+        context_.RenderIndent();
+        RenderForeignObject(*obj, context_);
+        context_.out.Put('\n');
+    }
+
+    void DocumentWriter::Finish()
+    {
+        Document::RenderEnd(context_.out);
     }
 } // namespace svg
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "memory_usage.h"
+#include "output_buffer.h"
+
 #include <cstdint>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <optional>
 #include <variant>
@@ -51,6 +56,8 @@ namespace svg
 
     std::ostream &operator<<(std::ostream &out, Color &color);
     std::ostream &operator<<(std::ostream &out, StrokeLineCap line_cap);
+    std::string_view ToString(StrokeLineCap line_cap);
+    std::string_view ToString(StrokeLineJoin line_join);
     std::ostream &operator<<(std::ostream &out, StrokeLineJoin line_join);
 
     struct ColorPrinter
@@ -122,6 +129,58 @@ namespace svg
         int indent = 0;
     };
 
+    // Настройки вывода SVG-документа в буфер
+    struct RenderOptions
+    {
+        // Отступ перед каждым объектом; 0 — без отступов
+        int indent = 2;
+        // Число знаков после точки у координат и размеров (хвостовые нули отбрасываются);
+        // отрицательное значение — формат std::ostream по умолчанию (6 значащих цифр)
+        int precision = -1;
+
+        bool operator==(const RenderOptions &other) const
+        {
+            return indent == other.indent && precision == other.precision;
+        }
+    };
+
+    /*
+     * Контекст вывода SVG-документа в буфер: числа записываются через std::to_chars
+     * в формате, заданном RenderOptions
+     */
+    struct BufferContext
+    {
+        BufferContext(io::OutputBuffer &out_o, const RenderOptions &options_o)
+            : out(out_o), options(options_o)
+        {
+        }
+
+        void RenderIndent() const
+        {
+            for (int i = 0; i < options.indent; ++i)
+            {
+                out.Put(' ');
+            }
+        }
+
+        void WriteNumber(double value) const
+        {
+            if (options.precision < 0)
+            {
+                out.WriteDouble(value);
+            }
+            else
+            {
+                out.WriteFixed(value, options.precision);
+            }
+        }
+
+        io::OutputBuffer &out;
+        const RenderOptions &options;
+    };
+
+    void RenderColor(const Color &color, const BufferContext &context);
+
     /*
      * Абстрактный базовый класс Object служит для унифицированного хранения
      * конкретных тегов SVG-документа
@@ -132,6 +191,13 @@ namespace svg
     public:
         void Render(const RenderContext &context) const;
 
+        // Оценка памяти объекта вместе с его динамическими данными. Наследники, объявленные вне svg,
+        // могут её не переопределять: тогда учитывается только базовая часть объекта
+        virtual size_t GetMemoryUsage() const
+        {
+            return sizeof(Object);
+        }
+
         virtual ~Object() = default;
 
     private:
@@ -194,40 +260,82 @@ namespace svg
             return AsOwner();
         }
 
+        // Задаёт класс CSS (атрибут class): повторяющиеся атрибуты выносятся в общий стиль <style>
+        Owner &SetClass(std::string class_name)
+        {
+            class_name_ = std::move(class_name);
+            return AsOwner();
+        }
+
     protected:
         ~PathProps() = default;
 
-        // Метод RenderAttrs выводит в поток общие для всех путей атрибуты fill и stroke
-        void RenderAttrs(std::ostream &out) const
+        // Выводит общие для всех путей атрибуты: class, fill и stroke
+        void RenderAttrs(const BufferContext &context) const
         {
             using namespace std::literals;
+            auto &out = context.out;
+
+            if (!class_name_.empty())
+            {
+                out.Write(" class=\""sv);
+                out.Write(class_name_);
+                out.Put('"');
+            }
 
             if (fill_color_)
             {
-                out << " fill=\""sv;
-                std::visit(ColorPrinter{out}, *fill_color_);
-                out << "\""sv;
+                out.Write(" fill=\""sv);
+                RenderColor(*fill_color_, context);
+                out.Put('"');
             }
+
             if (stroke_color_)
             {
-                out << " stroke=\""sv;
-                std::visit(ColorPrinter{out}, *stroke_color_);
-                out << "\""sv;
+                out.Write(" stroke=\""sv);
+                RenderColor(*stroke_color_, context);
+                out.Put('"');
             }
+
             if (width_)
             {
-                out << " stroke-width=\""sv << *width_ << "\""sv;
+                out.Write(" stroke-width=\""sv);
+                context.WriteNumber(*width_);
+                out.Put('"');
             }
+
             if (line_cap_)
             {
-                out << " stroke-linecap=\""sv << *line_cap_ << "\""sv;
+                out.Write(" stroke-linecap=\""sv);
+                out.Write(ToString(*line_cap_));
+                out.Put('"');
             }
+
             if (line_join_)
             {
-                out << " stroke-linejoin=\""sv << *line_join_ << "\""sv;
+                out.Write(" stroke-linejoin=\""sv);
+                out.Write(ToString(*line_join_));
+                out.Put('"');
             }
         }
 
+        // Память строковых цветов fill и stroke (остальные атрибуты хранятся в самом объекте)
+        size_t GetAttrsMemoryUsage() const
+        {
+            size_t result = memory::StringBytes(class_name_);
+            for (const auto *color : {&fill_color_, &stroke_color_})
+            {
+                if (*color)
+                {
+                    if (const auto *name = std::get_if<std::string>(&**color))
+                    {
+                        result += memory::StringBytes(*name);
+                    }
+                }
+            }
+            return result;
+        }
+
     private:
         Owner &AsOwner()
         {
@@ -241,6 +349,7 @@ namespace svg
         std::optional<double> width_;
         std::optional<StrokeLineCap> line_cap_;
         std::optional<StrokeLineJoin> line_join_;
+        std::string class_name_;
     };
 
     /*
@@ -253,8 +362,14 @@ namespace svg
         Circle &SetCenter(Point center);
         Circle &SetRadius(double radius);
 
+        size_t GetMemoryUsage() const override;
+
     private:
+        friend class Document;
+        friend class DocumentWriter;
+
         void RenderObject(const RenderContext &context) const override;
+        void RenderObject(const BufferContext &context) const;
 
         Point center_;
         double radius_ = 1.0;
@@ -270,11 +385,20 @@ namespace svg
         // Добавляет очередную вершину к ломаной линии
         Polyline &AddPoint(Point point);
 
+        // Резервирует место под вершины, чтобы ломаная заполнялась без перераспределений
+        Polyline &ReservePoints(size_t count);
+
+        size_t GetMemoryUsage() const override;
+
         /*
          * Прочие методы и данные, необходимые для реализации элемента <polyline>
          */
     private:
+        friend class Document;
+        friend class DocumentWriter;
+
         void RenderObject(const RenderContext &context) const override;
+        void RenderObject(const BufferContext &context) const;
 
         std::vector<Point> points_;
     };
@@ -292,8 +416,8 @@ namespace svg
         // Задаёт смещение относительно опорной точки (атрибуты dx, dy)
         Text &SetOffset(Point offset);
 
-        // Задаёт размеры шрифта (атрибут font-size)
-        Text &SetFontSize(uint32_t size);
+        // Задаёт размеры шрифта (атрибут font-size); std::nullopt — атрибут не выводится, размер задаёт стиль
+        Text &SetFontSize(std::optional<uint32_t> size);
 
         // Задаёт название шрифта (атрибут font-family)
         Text &SetFontFamily(std::string font_family);
@@ -304,29 +428,134 @@ namespace svg
         // Задаёт текстовое содержимое объекта (отображается внутри тега text)
         Text &SetData(std::string data);
 
+        size_t GetMemoryUsage() const override;
+
         // Прочие данные и методы, необходимые для реализации элемента <text>
     private:
+        friend class Document;
+        friend class DocumentWriter;
+
         void RenderObject(const RenderContext &context) const override;
+        void RenderObject(const BufferContext &context) const;
 
         Point pos_ = {0.0, 0.0};
         Point offset_ = {0.0, 0.0};
-        uint32_t size_ = 1;
+        std::optional<uint32_t> size_ = 1;
         std::string font_family_;
         std::string font_weight_;
         std::string data_;
     };
 
+    /*
+     * Класс Style моделирует элемент <style> с правилами CSS, общими для объектов документа
+     * https://developer.mozilla.org/en-US/docs/Web/SVG/Element/style
+     */
+    class Style final : public Object
+    {
+    public:
+        explicit Style(std::string rules) : rules_(std::move(rules))
+        {
+        }
+
+        size_t GetMemoryUsage() const override;
+
+    private:
+        friend class Document;
+        friend class DocumentWriter;
+
+        void RenderObject(const RenderContext &context) const override;
+        void RenderObject(const BufferContext &context) const;
+
+        std::string rules_;
+    };
+
+    /*
+     * Документ хранит Circle, Polyline, Text и Style по значению в одном непрерывном массиве
+     * и выводит их без виртуальных вызовов. Прочие наследники svg::Object, а также объекты,
+     * добавленные через интерфейс ObjectContainer (например, из Drawable::Draw),
+     * хранятся через указатель в том же массиве, порядок вывода совпадает с порядком добавления
+     */
     class Document : public ObjectContainer
     {
     public:
+        // Добавляет объект в документ; Circle, Polyline, Text и Style перемещаются в массив без отдельной аллокации
+        template <typename Obj>
+        void Add(Obj obj)
+        {
+            if constexpr (std::is_same_v<Obj, Circle> || std::is_same_v<Obj, Polyline> || std::is_same_v<Obj, Text> || std::is_same_v<Obj, Style>)
+            {
+                objects_.emplace_back(std::move(obj));
+            }
+            else
+            {
+                AddPtr(std::make_unique<Obj>(std::move(obj)));
+            }
+        }
+
         // Добавляет в svg-документ объект-наследник svg::Object
         void AddPtr(std::unique_ptr<Object> &&obj) override;
 
+        // Резервирует место под объекты
+        void Reserve(size_t count);
+
         // Выводит в ostream svg-представление документа
         void Render(std::ostream &out) const;
 
+        // Выводит svg-представление документа в буфер; с настройками по умолчанию
+        // результат совпадает с выводом в ostream
+        void Render(io::OutputBuffer &out, const RenderOptions &options = {}) const;
+
+        // Части вывода по отдельности: заголовок с открывающим тегом, строки объектов и закрывающий тег.
+        // Строки объектов нескольких документов можно склеивать между одними заголовком и концом
+        static void RenderBegin(io::OutputBuffer &out);
+        void RenderObjects(io::OutputBuffer &out, const RenderOptions &options = {}) const;
+        static void RenderEnd(io::OutputBuffer &out);
+
+        // Оценка памяти документа: список объектов и сами объекты
+        size_t GetMemoryUsage() const;
+
+    private:
+        using StoredObject = std::variant<Circle, Polyline, Text, Style, std::unique_ptr<Object>>;
+
+        std::vector<StoredObject> objects_;
+    };
+
+    /*
+     * Документ, который не хранит объекты: заголовок выводится при создании, каждый добавленный
+     * объект сразу выводится в буфер, закрывающий тег — в Finish(). Вывод совпадает с выводом
+     * svg::Document с теми же объектами и настройками, а память не зависит от числа объектов
+     */
+    class DocumentWriter : public ObjectContainer
+    {
+    public:
+        explicit DocumentWriter(io::OutputBuffer &out, const RenderOptions &options = {});
+
+        DocumentWriter(const DocumentWriter &) = delete;
+        DocumentWriter &operator=(const DocumentWriter &) = delete;
+
+        template <typename Obj>
+        void Add(Obj obj)
+        {
+            if constexpr (std::is_same_v<Obj, Circle> || std::is_same_v<Obj, Polyline> || std::is_same_v<Obj, Text> || std::is_same_v<Obj, Style>)
+            {
+                context_.RenderIndent();
+                obj.RenderObject(context_);
+                context_.out.Put('\n');
+            }
+            else
+            {
+                AddPtr(std::make_unique<Obj>(std::move(obj)));
+            }
+        }
+
+        void AddPtr(std::unique_ptr<Object> &&obj) override;
+
+        // Выводит закрывающий тег; после этого объекты добавлять нельзя
+        void Finish();
+
     private:
-        std::vector<std::unique_ptr<Object>> objects_;
+        RenderOptions options_;
+        BufferContext context_;
     };
 
 } // namespace svg
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace parallel
+{
+    thread_local ThreadPool *ThreadPool::current_pool_ = nullptr;
+    thread_local size_t ThreadPool::current_index_ = 0;
+
+    ThreadPool::ThreadPool(size_t thread_count)
+    {
+        thread_count = std::max<size_t>(thread_count, 1);
+        queues_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            queues_.push_back(std::make_unique<TaskQueue>());
+        }
+
+        threads_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            threads_.emplace_back([this, i]
+                                  { WorkerLoop(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard lock(wake_mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_all();
+
+        for (auto &thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::Submit(std::function<void()> task)
+    {
+        const size_t index = current_pool_ == this
+                                 ? current_index_
+                                 : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        // Счётчик увеличивается до публикации задачи: иначе перехватившая её TryRunTask
+        // успела бы уменьшить его первой, и беззнаковый pending_ переполнился бы
+        {
+            std::lock_guard lock(wake_mutex_);
+            pending_.fetch_add(1, std::memory_order_release);
+        }
+        {
+            std::lock_guard lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        wake_cv_.notify_one();
+    }
+
+    bool ThreadPool::RunPendingTask()
+    {
+        return TryRunTask(current_pool_ == this ? current_index_ : queues_.size());
+    }
+
+    void ThreadPool::ParallelFor(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)> &body)
+    {
+        chunk_size = std::max<size_t>(chunk_size, 1);
+        if (count <= chunk_size)
+        {
+            body(0, count);
+            return;
+        }
+
+        TaskGroup group(*this);
+        for (size_t begin = 0; begin < count; begin += chunk_size)
+        {
+            const size_t end = std::min(count, begin + chunk_size);
+            group.Run([&body, begin, end]
+                      { body(begin, end); });
+        }
+        group.Wait();
+    }
+
+    void ThreadPool::WorkerLoop(size_t index)
+    {
+        current_pool_ = this;
+        current_index_ = index;
+
+        while (true)
+        {
+            if (TryRunTask(index))
+            {
+                continue;
+            }
+
+            std::unique_lock lock(wake_mutex_);
+            wake_cv_.wait(lock, [this]
+                          { return stop_ || pending_.load(std::memory_order_acquire) > 0; });
+            if (stop_ && pending_.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    bool ThreadPool::TryRunTask(size_t own_index)
+    {
+        std::function<void()> task;
+
+        // Свою очередь разбираем с конца: последние добавленные задачи ещё "горячие" в кэше
+        if (own_index < queues_.size())
+        {
+            TaskQueue &own = *queues_[own_index];
+            std::lock_guard lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+
+        // Перехватываем самую старую задачу из чужой очереди
+        for (size_t shift = 1; !task && shift <= queues_.size(); ++shift)
+        {
+            TaskQueue &victim = *queues_[(own_index + shift) % queues_.size()];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+
+        if (!task)
+        {
+            return false;
+        }
+
+        pending_.fetch_sub(1, std::memory_order_acq_rel);
+        task();
+        return true;
+    }
+
+    TaskGroup::~TaskGroup()
+    {
+        // Задачи ссылаются на группу, поэтому дожидаемся их даже при исключении
+        try
+        {
+            Wait();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    void TaskGroup::Run(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            ++running_;
+        }
+
+        pool_.Submit([this, task = std::move(task)]
+                     {
+            std::exception_ptr error;
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard lock(mutex_);
+            if (error && !error_)
+            {
+                error_ = error;
+            }
+            if (--running_ == 0)
+            {
+                done_cv_.notify_all();
+            } });
+    }
+
+    void TaskGroup::Wait()
+    {
+        std::unique_lock lock(mutex_);
+        while (running_ > 0)
+        {
+            lock.unlock();
+            const bool ran = pool_.RunPendingTask();
+            lock.lock();
+            if (!ran && running_ > 0)
+            {
+                // Задачи группы выполняются другими потоками; просыпаемся и по таймауту,
+                // чтобы помочь с задачами, появившимися за это время
+                done_cv_.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+
+        if (error_)
+        {
+            std::exception_ptr error = std::exchange(error_, nullptr);
+            std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel
+{
+    /*
+     * Пул потоков с перехватом задач (work stealing).
+     * У каждого рабочего потока своя очередь: свои задачи он берёт с конца,
+     * а при пустой очереди забирает задачи из начала чужих очередей.
+     * Поток, ожидающий результата, может сам выполнять задачи через RunPendingTask
+     */
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        size_t GetThreadCount() const
+        {
+            return threads_.size();
+        }
+
+        // Задача из рабочего потока попадает в его собственную очередь, иначе — в очереди по кругу
+        void Submit(std::function<void()> task);
+
+        // Выполняет одну ожидающую задачу в вызывающем потоке; false, если задач нет
+        bool RunPendingTask();
+
+        // Вызывает body(begin, end) для частей диапазона [0, count) и ждёт завершения всех частей.
+        // Вызывающий поток участвует в работе, поэтому вложенные вызовы не блокируют пул
+        void ParallelFor(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)> &body);
+
+    private:
+        struct TaskQueue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<TaskQueue>> queues_;
+        std::vector<std::thread> threads_;
+        std::atomic<size_t> next_queue_{0};
+        std::atomic<size_t> pending_{0};
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cv_;
+        bool stop_ = false;
+
+        static thread_local ThreadPool *current_pool_;
+        static thread_local size_t current_index_;
+
+        void WorkerLoop(size_t index);
+        bool TryRunTask(size_t own_index);
+    };
+
+    /*
+     * Счётчик незавершённых задач: Wait() возвращается, когда все добавленные задачи
+     * отработали, и пробрасывает первое возникшее в них исключение
+     */
+    class TaskGroup
+    {
+    public:
+        explicit TaskGroup(ThreadPool &pool) : pool_(pool) {}
+        ~TaskGroup();
+
+        void Run(std::function<void()> task);
+        void Wait();
+
+    private:
+        ThreadPool &pool_;
+        std::mutex mutex_;
+        std::condition_variable done_cv_;
+        size_t running_ = 0;
+        std::exception_ptr error_;
+    };
+}
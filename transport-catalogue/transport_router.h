@@ -1,48 +1,72 @@
-#pragma once
-
-#include "router.h"
-#include "transport_catalogue.h"
-
-#include <memory>
-#include <vector>
-
-namespace transport_catalogue
-{
-    struct RouteSettings
-    {
-        int bus_wait_time = 0;
-        double bus_velocity = 0.0;
-    };
-
-    struct GraphRouteInfo
-    {
-        std::optional<graph::Router<double>::RouteInfo> route_setting;
-        std::vector<graph::Edge<double>> edges;
-    };
-
-    class Router
-    {
-    public:
-        Router() = default;
-
-        Router(const RouteSettings &settings, const TransportCatalogue &catalogue)
-        {
-            bus_wait_time_ = settings.bus_wait_time;
-            bus_velocity_ = settings.bus_velocity;
-            BuildGraph(catalogue);
-        }
-
-        const transport_catalogue::GraphRouteInfo FindInfoRoute(const std::string_view stop_from, const std::string_view stop_to) const;
-
-    private:
-        int bus_wait_time_ = 0;
-        double bus_velocity_ = 0.0;
-
-        graph::DirectedWeightedGraph<double> graph_;
-        std::map<std::string, graph::VertexId> stop_ids_;
-        std::unique_ptr<graph::Router<double>> router_;
-
-        const graph::DirectedWeightedGraph<double> &BuildGraph(const TransportCatalogue &catalogue);
-        const graph::DirectedWeightedGraph<double> &GetGraph() const;
-    };
+#pragma once
+
+#include "router.h"
+#include "run_stats.h"
+#include "transport_catalogue.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace transport_catalogue
+{
+    struct RouteSettings
+    {
+        int bus_wait_time = 0;
+        double bus_velocity = 0.0;
+    };
+
+    struct GraphRouteInfo
+    {
+        std::optional<graph::Router<double>::RouteInfo> route_setting;
+        std::vector<graph::Edge<double>> edges;
+    };
+
+    class Router
+    {
+    public:
+        Router() = default;
+
+        // Граф и предрасчёт маршрутов строятся не здесь, а при первом поиске маршрута или вызове Build()
+        // stats — необязательный отчёт, в который записываются время построения и размеры графа
+        Router(const RouteSettings &settings, const TransportCatalogue &catalogue, stats::RunStats *stats = nullptr)
+            : catalogue_(&catalogue), stats_(stats)
+        {
+            bus_wait_time_ = settings.bus_wait_time;
+            bus_velocity_ = settings.bus_velocity;
+        }
+
+        // Строит граф и предрасчёт маршрутов, если они ещё не построены. Можно вызвать из фонового потока:
+        // параллельный поиск маршрута дождётся окончания построения
+        void Build() const;
+
+        // Первый этап Build(): только граф, без предрасчёта маршрутов (например, чтобы замерить этапы по отдельности)
+        void BuildGraph() const;
+
+        const transport_catalogue::GraphRouteInfo FindInfoRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+
+        // Остановка, которой принадлежит вершина графа (у каждой остановки две вершины: до и после ожидания)
+        const Stop *GetStopByVertex(graph::VertexId vertex) const;
+
+        // Граф маршрутов; до вызова Build(), BuildGraph() или первого поиска маршрута он пуст
+        const graph::DirectedWeightedGraph<double> &GetGraph() const;
+
+        // Оценка памяти предрасчёта маршрутов и индекса остановок; граф учитывается отдельно через GetGraph()
+        size_t GetMemoryUsage() const;
+
+    private:
+        int bus_wait_time_ = 0;
+        double bus_velocity_ = 0.0;
+        const TransportCatalogue *catalogue_ = nullptr;
+        stats::RunStats *stats_ = nullptr;
+
+        mutable std::once_flag graph_once_;
+        mutable std::once_flag build_once_;
+        mutable graph::DirectedWeightedGraph<double> graph_;
+        mutable std::map<std::string, graph::VertexId> stop_ids_;
+        mutable std::vector<const Stop *> vertex_stops_;
+        mutable std::unique_ptr<graph::Router<double>> router_;
+
+        void FillGraph(const TransportCatalogue &catalogue) const;
+    };
 }
\ No newline at end of file